@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "graphics/gfx/font_renderer.h"
+#include "utils/mapped_file.h"
+
+// Decoded textures and rasterized glyphs baked into a single file, so later launches can skip
+// PNG decoding and FreeType rasterization.
+//
+// The file is keyed by a hash of the source assets and rejected when the sources change.
+// Cached texture pixels point straight into the memory mapped file and stay valid while the
+// cache is open.
+class AssetCache
+{
+public:
+    static const uint32_t VERSION = 1;
+
+    struct Texture
+    {
+        std::string name;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        // width * height RGBA pixels
+        const unsigned char* pixels = nullptr;
+    };
+
+    struct Font
+    {
+        std::string path;
+        unsigned int fontSize = 0;
+        std::vector<gfx::Glyph> glyphs;
+    };
+
+    // hashes the contents of every file along with extraKey, which should describe any other
+    // input that changes the baked data such as font sizes or the glyph set
+    static uint64_t hashSources(const std::vector<std::string>& paths, const std::string& extraKey);
+
+    // returns false if the file is missing, corrupt, from another version or baked from other sources
+    bool open(const std::string& path, uint64_t sourceHash);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    const std::vector<Texture>& getTextures() const { return m_textures; }
+    // returns nullptr if the font is not in the cache
+    const Font* getFont(const std::string& path, unsigned int fontSize) const;
+
+    // textures are written as width * height RGBA pixels
+    static bool write(const std::string& path, uint64_t sourceHash, const std::vector<Texture>& textures, const std::vector<Font>& fonts);
+
+private:
+    MappedFile m_file;
+    std::vector<Texture> m_textures;
+    std::vector<Font> m_fonts;
+};
@@ -55,8 +55,13 @@ public:
     glm::vec3 rayDirFromNDC(float x, float y);
     glm::vec3 rayDirFromMouse(float mouseX, float mouseY);
     Frustum getFrustum() const;
+    // frustum with the field of view widened by fovPadding degrees, so it still contains the
+    // view after the camera turns by up to half the padding. Returns the frozen frustum if frozen
+    Frustum getPaddedFrustum(float fovPadding) const;
 private:
     Frustum m_frustum;
+    // the one place the near and far planes and aspect ratio are set, so the draw and search frustums agree
+    glm::mat4 getProjectionMatrix(float fovDegrees) const;
     void updateCameraVectors();
     glm::vec2 getNormalizedDeviceCoords(float mouseX, float mouseY);
     glm::vec4 toEyeCoords(const glm::vec4& clipCoords);
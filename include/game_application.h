@@ -10,6 +10,7 @@
 #include "world/world.h"
 #include "input_manager.h"
 #include "graphics/world_renderer.h"
+#include "graphics/render_debug_panel.h"
 #include "resource_loader.h"
 
 class GameApplication
@@ -63,9 +64,22 @@ private:
 
     World m_world;
     WorldRenderer m_worldRenderer{&m_world.getChunkMap(), &s_resourceManager};
+    RenderDebugPanel m_renderDebugPanel;
+
+    // resolved once the shaders are loaded, both are set every frame
+    int m_screenQuadResolutionLocation = -1;
+    int m_screenQuadCrosshairLocation = -1;
 
     float m_dayNightFrac = 0.5f;
     BlockType m_selectedBlockType = BlockType::Grass;
+    float m_editRadius = 8.0f;
+    // blocks changed, chunks remeshed and time taken by the last world edit
+    size_t m_lastEditBlocks = 0;
+    size_t m_lastEditChunks = 0;
+    float m_lastEditMs = 0.0f;
+
+    // fills a sphere of m_editRadius in front of the camera as one WorldEdit
+    void editSphere(BlockType type);
 
     static void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 };
\ No newline at end of file
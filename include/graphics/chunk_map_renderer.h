@@ -6,63 +6,225 @@
 #include <memory>
 #include <atomic>
 #include <queue>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
 #include "chunk_mesh.h"
+#include "chunk_mesh_arena.h"
+#include "chunk_mesh_pool.h"
 #include "utils/glm_hash.h"
 #include "camera.h"
 #include "resource_manager.h"
-#include "graphics/gfx/texture_atlas.h"
+#include "graphics/gfx/texture_array.h"
 #include "graphics/gfx/shader.h"
 #include "utils/blocking_queue.h"
 #include "utils/blocking_deque.h"
 #include "utils/geometry.h"
+#include "graphics/world_render_options.h"
+
+struct ChunkBuildNode
+{
+    ChunkSnapshot snapshot;
+    uint32_t generation = 0;
+    ChunkMeshFormat format = ChunkMeshFormat::Vertices;
+    int lod = 0;
+};
 
 struct ChunkReadyNode
 {
     glm::ivec3 chunkPos;
     std::shared_ptr<ChunkMesh> chunkMesh;
+    uint32_t generation = 0;
+};
+
+struct MeshUploadStats
+{
+    int uploadsLastFrame = 0;
+    size_t bytesLastFrame = 0;
+    int queuedMeshes = 0;
+    size_t queuedBytes = 0;
+    // frames where the upload budget ran out before the pending uploads were drained
+    int stallFrames = 0;
+};
+
+struct ChunkDrawStats
+{
+    // chunk layers drawn last frame
+    int drawnChunks = 0;
+    int drawCalls = 0;
+    // CPU time spent culling the active chunks
+    float cullMs = 0.0f;
+    // CPU time spent building and submitting the draw batches
+    float submitMs = 0.0f;
+    // CPU time of the last visible set search
+    float searchMs = 0.0f;
+    int framesSinceSearch = 0;
+    int occluders = 0;
+    // active chunks skipped because the occlusion buffer hides them
+    int occludedChunks = 0;
+    float occlusionMs = 0.0f;
+    // visible chunks at each level of detail
+    std::array<int, ChunkMesh::MAX_LOD + 1> lodChunks{};
 };
 
 class ChunkMapRenderer
 {
 public:
-    // Chunks queued due to block updates are always added to the front of the queue
-    // and may cause the queue exceed this size.
-    // This value is primarily used to limit the number of chunks queued from the frustum
-    // to allow for a more responsive frustum queueing.
-    static const int MAX_BUILD_QUEUE_SIZE = 16;
+    // only the closest opaque chunks are rasterized into the occlusion buffer
+    static const int MAX_OCCLUDERS = 64;
+    static const int OCCLUDER_RADIUS = 8;
+    // the visible set search uses a frustum this many degrees wider than the view, and is rerun
+    // once the camera turns further than the threshold since the last search
+    static constexpr float SEARCH_FOV_PADDING = 10.0f;
+    static constexpr float SEARCH_ROTATION_THRESHOLD = 4.0f;
+    // how often a search that could not queue every chunk it found is retried
+    static constexpr float SEARCH_RETRY_MS = 100.0f;
+    // how far, in blocks, the camera moves before the translucent faces of its chunk are sorted again
+    static constexpr float TRANSLUCENT_SORT_DISTANCE = 0.25f;
+    // meshes up to this many chunks from the camera's chunk keep their translucent faces
+    static const int TRANSLUCENT_KEEP_RANGE = 1;
 
     ChunkMapRenderer() = default;
     ChunkMapRenderer(ChunkMap* chunkMap) : m_chunkMap(chunkMap) {}
     ~ChunkMapRenderer() { stopThread(); }
 
-    void setupResources(gfx::Shader* chunkShader, gfx::TextureAtlas<BlockTexture>* textureAtlas);
+    void setupResources(gfx::Shader* chunkShader, gfx::Shader* chunkFaceShader, gfx::TextureArray<BlockTexture>* blockTextures);
 
-    void updateBuildQueue(bool useSmoothLighting);
+    // uploads finished meshes closest to the camera first until the per frame budget is used up.
+    // At least one mesh is uploaded per frame so the queue always makes progress.
+    void updateBuildQueue(const glm::ivec3& cameraChunkPos, bool useSmoothLighting);
     
+    // searches outward from the camera's chunk, activating loaded meshes and queueing builds
+    // for chunks in the frustum. With cave culling the search only passes between chunks
+    // whose faces can see each other, so chunks hidden underground are neither built nor drawn
     void queueFrustum(const Frustum& frustum, const glm::ivec3& chunkPos, int radius);
+    // keeps the visible set up to date, rerunning queueFrustum only when the camera enters another
+    // chunk, turns past SEARCH_ROTATION_THRESHOLD, the radius changes, or new meshes were uploaded
+    void updateVisibleSet(const Camera& camera, int radius);
     void queueChunkRadius(const glm::ivec3& chunkPos, int radius);
     void queueBlockUpdate(const glm::ivec3& blockPos, BlockType blockType);
+    // rebuilds the meshes of chunks changed by a WorldEdit. Lighting is left to WorldEdit::commit
+    void queueChunkUpdates(const std::vector<glm::ivec3>& chunkPositions);
 
-    void draw(const Camera& camera, int viewDistance, bool useAO, float aoFactor, float dayNightFrac);
+    // rasterizes the closest opaque chunks into the occlusion buffer. Must be called before
+    // queueFrustum and draw so both test against the current view
+    void updateOcclusion(const Camera& camera);
 
-    void meshBuildThreadFunc(const gfx::TextureAtlas<BlockTexture>& atlas, bool useSmoothLighting);
+    // draws opaque chunks front to back for early depth rejection and translucent chunks
+    // back to front so they blend in the right order
+    // the camera matrices and lighting state come from the FrameData uniform block
+    void draw(const Camera& camera, int viewDistance);
 
-    void startBuildThread(bool useSmoothLighting);
+    void meshBuildThreadFunc(bool useSmoothLighting);
+
+    // a thread count of 0 picks one based on the available hardware threads
+    void startBuildThreads(bool useSmoothLighting, int threadCount = 0);
     void stopThread() { m_stopThread = true; }
 
+    void setMaxBuildsInFlight(int maxBuilds) { m_maxBuildsInFlight = std::max(1, maxBuilds); }
+    int getMaxBuildsInFlight() const { return m_maxBuildsInFlight; }
+    int getBuildsInFlight() const { return m_buildsInFlight; }
+    int getBuildThreadCount() const { return m_buildThreadCount; }
+
+    void setUploadBudget(size_t maxBytesPerFrame, float maxMsPerFrame);
+    void setCaveCulling(bool useCaveCulling);
+    void setOcclusionCulling(bool useOcclusionCulling) { m_useOcclusionCulling = useOcclusionCulling; }
+    // chunks are meshed one level of detail coarser every lodDistance chunks from the camera.
+    // 0 meshes every chunk at full resolution
+    void setLodDistance(int lodDistance);
+    // switching formats drops every loaded mesh so they are rebuilt in the new format
+    void setMeshFormat(ChunkMeshFormat format);
+    ChunkMeshFormat getMeshFormat() const { return m_meshArena.getFormat(); }
+    const MeshUploadStats& getUploadStats() const { return m_uploadStats; }
+    const ChunkMeshArena& getMeshArena() const { return m_meshArena; }
+    const ChunkDrawStats& getDrawStats() const { return m_drawStats; }
+    // CPU memory held by meshes that are loaded or waiting to be uploaded
+    size_t getMeshCPUMemoryUsage() const;
+    size_t getLoadedMeshCount() const { return m_chunkMeshes.size(); }
+    ChunkMeshPoolStats getMeshPoolStats() const { return m_meshPool.getStats(); }
+
 private:
     ChunkMap* m_chunkMap = nullptr;
+    // declared before the mesh maps so it outlives every mesh stored in them
+    ChunkMeshArena m_meshArena;
+    ChunkMeshPool m_meshPool;
     std::unordered_map<glm::ivec3, std::shared_ptr<ChunkMesh>, glm_ivec3_hash, glm_ivec3_equal> m_chunkMeshes;
     std::unordered_map<glm::ivec3, std::shared_ptr<ChunkMesh>, glm_ivec3_hash, glm_ivec3_equal> m_activeChunkMeshes;
-    BlockingDeque<ChunkSnapshot> m_chunksToBuild;
+    BlockingDeque<ChunkBuildNode> m_chunksToBuild;
     BlockingQueue<ChunkReadyNode> m_chunksToSubmit;
-    std::unordered_set<glm::ivec3, glm_ivec3_hash, glm_ivec3_equal> m_chunksInBuildQueue;
+    std::vector<ChunkReadyNode> m_pendingUploads;
+    size_t m_uploadBudgetBytes = RenderOptions::DEFAULT_UPLOAD_BUDGET_KB * 1024;
+    float m_uploadBudgetMs = RenderOptions::DEFAULT_UPLOAD_BUDGET_MS;
+    MeshUploadStats m_uploadStats;
+    ChunkDrawStats m_drawStats;
+    // latest build generation queued for each chunk. Meshes from older generations are stale
+    std::unordered_map<glm::ivec3, uint32_t, glm_ivec3_hash, glm_ivec3_equal> m_chunksInBuildQueue;
+    std::unordered_set<glm::ivec3, glm_ivec3_hash, glm_ivec3_equal> m_dirtyChunks;
+    uint32_t m_nextBuildGeneration = 1;
+    int m_buildsInFlight = 0;
+    int m_maxBuildsInFlight = RenderOptions::DEFAULT_MAX_BUILDS_IN_FLIGHT;
+    int m_buildThreadCount = 0;
+    bool m_useCaveCulling = true;
+    int m_lodDistance = RenderOptions::DEFAULT_LOD_DISTANCE;
+    // chunk the levels of detail are measured from, the camera's chunk as of the last updateVisibleSet
+    glm::ivec3 m_lodCenter{0};
+    // state of the last visible set search, see updateVisibleSet
+    glm::ivec3 m_searchChunkPos{0};
+    glm::vec3 m_searchForward{0.0f};
+    int m_searchRadius = -1;
+    bool m_searchDirty = true;
+    // the last search skipped chunks it could not queue yet
+    bool m_searchIncomplete = false;
+    std::chrono::steady_clock::time_point m_searchTime;
+    bool m_useOcclusionCulling = true;
+    OcclusionBuffer m_occlusionBuffer;
+    std::vector<std::pair<float, glm::ivec3>> m_occluderCandidates;
+    // active chunks within the view distance and their bounds, frustum culled in one batch
+    std::vector<std::pair<glm::ivec3, ChunkMesh*>> m_cullCandidates;
+    AABBList m_cullBounds;
+    std::vector<uint32_t> m_visibleIndices;
+    // visible chunks in front to back order
+    std::vector<ChunkMesh*> m_drawList;
+    struct DrawOrderEntry
+    {
+        uint32_t distance2;
+        glm::ivec3 chunkPos;
+        ChunkMesh* chunkMesh;
+    };
+    // active chunks sorted front to back from m_drawOrderChunkPos. Only rebuilt when the camera
+    // enters another chunk or the active set changes
+    std::vector<DrawOrderEntry> m_drawOrder;
+    std::vector<DrawOrderEntry> m_drawOrderScratch;
+    glm::ivec3 m_drawOrderChunkPos{0};
+    bool m_drawOrderDirty = true;
+    // chunk the kept translucent faces are centered on, see TRANSLUCENT_KEEP_RANGE
+    glm::ivec3 m_translucentSortChunkPos{0};
+    TranslucentSortScratch m_translucentSortScratch;
     std::atomic_bool m_stopThread = false;
     
     gfx::Shader* m_chunkShader = nullptr;
-    gfx::TextureAtlas<BlockTexture>* m_textureAtlas = nullptr;
+    gfx::Shader* m_chunkFaceShader = nullptr;
+    gfx::TextureArray<BlockTexture>* m_blockTextures = nullptr;
+    // texture array layer of every block texture, indexed by BlockTexture
+    std::array<int, ChunkMesh::MAX_BLOCK_TEXTURES> m_textureLayers{};
+    // location of uTextureLayers in the vertex shader and in the face shader
+    std::array<int, 2> m_textureLayersLocations{-1, -1};
+    // shader that holds the current table, nullptr until it is first uploaded
+    gfx::Shader* m_textureLayersShader = nullptr;
     
     void checkPointers() const;
+    // returns true if any layer changed since the last call
+    bool updateTextureLayers();
     bool checkNeighborChunks(const glm::ivec3& chunkPos, bool checkSelf=false) const;
+    bool isChunkOccluded(const glm::ivec3& chunkPos) const;
     void setDirty(const glm::ivec3& chunkPos);
+    void updateDrawOrder(const glm::ivec3& cameraChunkPos);
+    void updateTranslucentSort(const Camera& camera);
+    static bool isInTranslucentSortRange(const glm::ivec3& chunkPos, const glm::ivec3& cameraChunkPos);
+    void queueBuild(const ChunkSnapshot& snapshot, bool prioritize);
+    // bias moves the chunk that many chunks closer to the camera
+    int getLodLevel(const glm::ivec3& chunkPos, float bias = 0.0f) const;
+    bool needsLodRebuild(const ChunkMesh& chunkMesh, const glm::ivec3& chunkPos) const;
 };
\ No newline at end of file
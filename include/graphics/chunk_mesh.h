@@ -3,14 +3,14 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <array>
-#include <atomic>
+#include <optional>
 #include "world/chunk.h"
 #include "world/world.h"
-#include "graphics/gfx/mesh.h"
+#include "graphics/chunk_mesh_arena.h"
+#include "graphics/chunk_visibility.h"
 #include "utils/direction_utils.h"
 #include "world/chunk_snapshot.h"
 #include "world/block_data.h"
-#include "graphics/gfx/texture_atlas.h"
 
 enum class RenderLayer
 {
@@ -19,58 +19,126 @@ enum class RenderLayer
     Transparent = 2
 };
 
+// CPU side mesh data of every render layer, indexed by RenderLayer. Kept apart from ChunkMesh
+// so the vectors and their capacity can be recycled between builds, see ChunkMeshPool
+struct ChunkMeshBuffers
+{
+    static const int LAYER_COUNT = 3;
+
+    std::array<std::vector<uint32_t>, LAYER_COUNT> layers;
+
+    // keeps the capacity of every layer
+    void clear();
+    size_t getSizeBytes() const;
+    size_t getCapacityBytes() const;
+};
+
+// scratch buffers of ChunkMesh::sortTranslucentFaces, kept by the caller so their capacity
+// is reused between sorts
+struct TranslucentSortScratch
+{
+    struct FaceKey
+    {
+        uint32_t key;
+        uint32_t face;
+    };
+
+    std::vector<FaceKey> keys;
+    std::vector<FaceKey> keyScratch;
+    std::vector<uint32_t> sortedFaces;
+};
+
 class ChunkMesh
 {
 public:
+    // size of the texture layer table the vertex shader resolves texture indices with
+    static const int MAX_BLOCK_TEXTURES = 64;
+    // coarsest level of detail. Level n meshes the chunk as cells of 2^n blocks
+    static const int MAX_LOD = 3;
+
     ChunkMesh() = default;
-    ~ChunkMesh() = default;
+    ~ChunkMesh();
 
     ChunkMesh(const ChunkMesh&) = delete;
     ChunkMesh& operator=(const ChunkMesh&) = delete;
-    ChunkMesh(ChunkMesh&&) = default;
-    ChunkMesh& operator=(ChunkMesh&&) = default;
+    ChunkMesh(ChunkMesh&& other) noexcept;
+    ChunkMesh& operator=(ChunkMesh&& other) noexcept;
 
-    void setup();
+    // uploads the mesh into the shared arena. The CPU side copy is left for the caller to
+    // recycle with takeBuffers() or free with releaseCPUData(). The arena must outlive this mesh
+    void setup(ChunkMeshArena* arena, const glm::ivec3& chunkPos);
 
-    void draw(RenderLayer layer=RenderLayer::Opaque);
+    const ChunkMeshArena::Region& getRegion(RenderLayer layer) const;
 
     void clearMesh();
+    void releaseRegions();
+    void releaseCPUData();
+
+    // hands the CPU side buffers over without freeing them, so they can be reused for another build
+    ChunkMeshBuffers takeBuffers();
+    void setBuffers(ChunkMeshBuffers&& buffers);
+
+    // keeps a copy of the translucent layer after the buffers are taken, so its faces can be
+    // sorted for a camera inside the chunk. Must be called after setup()
+    void retainTranslucentFaces();
+    // reads the translucent faces back from the arena for a mesh that did not retain them.
+    // Returns false if the mesh has no translucent faces in the arena
+    bool restoreTranslucentFaces();
+    void releaseTranslucentFaces();
+    bool hasTranslucentFaces() const { return !m_translucentFaces.empty(); }
+    // reorders the retained translucent faces back to front as seen from viewPos, given in
+    // chunk local block coordinates, and rewrites them into the arena
+    void sortTranslucentFaces(const glm::vec3& viewPos, TranslucentSortScratch& scratch);
+    // position the translucent faces were last sorted for, if they were sorted since setup()
+    const std::optional<glm::vec3>& getTranslucentSortPos() const { return m_translucentSortPos; }
+
+    // the format must match the one the arena passed to setup() was created with.
+    // A lod above 0 builds a downsampled mesh, see buildLodMesh
+    void buildMesh(const ChunkSnapshot& snapshot, bool smoothLighting=true, ChunkMeshFormat format=ChunkMeshFormat::Vertices, int lod=0);
+
+    int getLod() const { return m_lod; }
+
+    // face to face visibility through the chunk, computed by buildMesh
+    const ChunkVisibility& getVisibility() const { return m_visibility; }
+
+    // size in bytes of the mesh data uploaded by setup()
+    size_t getUploadSize() const;
+    // bytes currently reserved by the CPU side mesh data
+    size_t getCPUMemoryUsage() const;
 
-    void buildMesh(const ChunkSnapshot& snapshot, const gfx::TextureAtlas<BlockTexture>& atlas, bool smoothLighting=true);
-
-    void submitBuffers();
-
-    void setDirty(bool dirty) { m_dirty.store(dirty); }
-    bool isDirty() const { return m_dirty.load(); }
-    
 private:
-    gfx::Mesh m_mesh;
-    std::vector<float> m_vertices;
-    std::vector<unsigned int> m_indices;
-    unsigned int m_indexCounter = 0;
-
-    gfx::Mesh m_meshTranslucent;
-    std::vector<float> m_verticesTranslucent;
-    std::vector<unsigned int> m_indicesTranslucent;
-    unsigned int m_indexCounterTranslucent = 0;
+    ChunkMeshArena* m_arena = nullptr;
+    glm::ivec3 m_chunkPos{0};
+    ChunkMeshFormat m_format = ChunkMeshFormat::Vertices;
+    int m_lod = 0;
+    ChunkVisibility m_visibility = ChunkVisibility::allVisible();
 
-    gfx::Mesh m_meshTransparent;
-    std::vector<float> m_verticesTransparent;
-    std::vector<unsigned int> m_indicesTransparent;
-    unsigned int m_indexCounterTransparent = 0;
+    ChunkMeshArena::Region m_region;
+    ChunkMeshArena::Region m_regionTranslucent;
+    ChunkMeshArena::Region m_regionTransparent;
 
-    std::atomic<bool> m_dirty = false;
+    // packed vertices or face records depending on m_format
+    ChunkMeshBuffers m_buffers;
+    std::vector<uint32_t> m_translucentFaces;
+    std::optional<glm::vec3> m_translucentSortPos;
 
     void addFace(
         const glm::ivec3 &pos, 
         BlockFace face, 
-        std::array<float, 8> texCoords, 
+        BlockTexture texture, 
         std::array<int, 4> aoValues, 
         std::array<glm::vec4, 4> lightLevels, 
         RenderLayer layer,
-        bool flipQuad
+        bool flipQuad,
+        int scale=1
     );
 
+    // meshes the chunk as cells of 2^m_lod blocks. Cells with any opaque block stay opaque,
+    // so the coarse volume always covers the full resolution one. Faces on the chunk border
+    // are only skipped when every neighbouring block hides them, which keeps the seams between
+    // chunks of different levels closed
+    void buildLodMesh(const ChunkSnapshot& snapshot);
+
     std::array<int, 12> getFaceCoords(BlockFace face);
     std::array<int, 4> getAOValues(const glm::ivec3& blockPos, BlockFace face, const ChunkSnapshot& snapshot);
     std::array<glm::vec4, 4> getLightValues(const glm::ivec3& blockPos, BlockFace face, const ChunkSnapshot& snapshot, bool smoothLighting=true);
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "graphics/gfx/buffer_arena.h"
+
+enum class ChunkMeshFormat
+{
+    // 4 vertices per face, read through a vertex attribute
+    Vertices = 0,
+    // 1 record per face, read from a buffer texture and expanded into a quad in the vertex shader
+    Faces = 1
+};
+
+// Shared mesh storage for every chunk mesh, drawn through a single VAO.
+//
+// Chunk meshes are lists of quads, so they do not store indices. All of them are drawn with
+// one static 16 bit quad index buffer and a base vertex. Meshes with more than
+// MAX_QUADS_PER_DRAW quads are split into several draws.
+//
+// Depending on the format an element of the arena is either a vertex or a whole face. Both are
+// two packed words, see ChunkMesh::addFace. In the face format the base vertex of a draw is
+// 4 times the face offset, so the shader finds its face with gl_VertexID / 4.
+//
+// Allocations are aligned to pages of PAGE_ELEMENTS elements and every page belongs to a
+// single chunk. The chunk position and level of detail of each page are stored in a buffer
+// texture, which the shader reads with its element index / PAGE_ELEMENTS. This lets a whole layer be drawn with
+// one multi-draw call without any per chunk uniforms.
+class ChunkMeshArena
+{
+public:
+    static const int WORDS_PER_ELEMENT = 2;
+    static const int VERTICES_PER_QUAD = 4;
+    static const int INDICES_PER_QUAD = 6;
+    // the most quads 16 bit indices can address
+    static const int MAX_QUADS_PER_DRAW = (1 << 16) / VERTICES_PER_QUAD;
+    static const int PAGE_ELEMENTS = 256;
+    static const size_t INITIAL_ELEMENT_CAPACITY = 1 << 20;
+    // texture units the page table and the face records are bound to while drawing
+    static const int PAGE_TABLE_TEXTURE_UNIT = 1;
+    static const int FACE_TEXTURE_UNIT = 2;
+
+    struct Region
+    {
+        gfx::BufferArena::Handle elements = gfx::BufferArena::INVALID_HANDLE;
+        unsigned int quadCount = 0;
+
+        bool isValid() const { return quadCount != 0; }
+    };
+
+    ChunkMeshArena() = default;
+    ~ChunkMeshArena();
+
+    ChunkMeshArena(const ChunkMeshArena&) = delete;
+    ChunkMeshArena& operator=(const ChunkMeshArena&) = delete;
+    ChunkMeshArena(ChunkMeshArena&&) = delete;
+    ChunkMeshArena& operator=(ChunkMeshArena&&) = delete;
+
+    void setup(ChunkMeshFormat format = ChunkMeshFormat::Vertices);
+
+    Region allocate(const glm::ivec3& chunkPos, const std::vector<uint32_t>& data, int lod = 0);
+    void free(Region& region);
+    // overwrites the contents of a region in place. data must hold as many elements as the region
+    void update(const Region& region, const std::vector<uint32_t>& data);
+    // reads the contents of a region back from the GPU into data
+    void read(const Region& region, std::vector<uint32_t>& data) const;
+
+    // binds the shared VAO and page table. Must be called before drawing a batch
+    void bind();
+
+    // regions added to the batch are drawn together with a single multi-draw call.
+    // Uses glMultiDrawElementsIndirect when GL 4.3 is available and falls back to glMultiDrawElementsBaseVertex.
+    void clearBatch();
+    void addToBatch(const Region& region);
+    // returns the number of draw calls issued
+    int drawBatch();
+
+    bool defragment();
+
+    void destroy();
+
+    ChunkMeshFormat getFormat() const { return m_format; }
+    bool usesIndirectDraw() const { return m_useIndirect; }
+    size_t getCapacityBytes() const;
+    size_t getUsedBytes() const;
+    size_t getFreeBlockCount() const;
+
+private:
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    ChunkMeshFormat m_format = ChunkMeshFormat::Vertices;
+    int m_elementsPerQuad = VERTICES_PER_QUAD;
+
+    unsigned int m_vao = 0;
+    unsigned int m_quadIndexBuffer = 0;
+    gfx::BufferArena m_elementArena;
+    // buffer texture over the element arena, only used by the face format
+    unsigned int m_faceTexture = 0;
+
+    // element buffer currently attached to the VAO or face texture. The arena replaces its buffer when it grows or compacts
+    unsigned int m_boundElementBuffer = 0;
+
+    // page table entry of every allocation: chunk offset in xyz, level of detail in w
+    std::unordered_map<gfx::BufferArena::Handle, glm::ivec4> m_elementOwners;
+    std::vector<glm::ivec4> m_pageTable;
+    unsigned int m_pageBuffer = 0;
+    unsigned int m_pageTexture = 0;
+    size_t m_pageBufferSize = 0;
+    bool m_pageTableDirty = false;
+
+    bool m_useIndirect = false;
+    unsigned int m_indirectBuffer = 0;
+    size_t m_indirectBufferSize = 0;
+    std::vector<DrawElementsIndirectCommand> m_indirectCommands;
+    std::vector<GLsizei> m_batchCounts;
+    std::vector<GLint> m_batchBaseVertices;
+    // every draw starts at the first index, but glMultiDrawElementsBaseVertex still wants one offset per draw
+    std::vector<const void*> m_batchIndexOffsets;
+
+    void setupQuadIndexBuffer();
+    void attachBuffers();
+    void writePages(gfx::BufferArena::Handle elements, const glm::ivec4& page);
+    GLint getBaseVertex(const Region& region) const;
+    void rebuildPageTable();
+    void uploadPageTable();
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include "graphics/chunk_mesh.h"
+
+struct ChunkMeshPoolStats
+{
+    size_t pooledMeshes = 0;
+    size_t pooledBuffers = 0;
+    size_t pooledBytes = 0;
+    uint64_t builds = 0;
+    // meshes and buffer sets created because the pool was empty
+    uint64_t meshAllocations = 0;
+    uint64_t bufferAllocations = 0;
+    // builds that had to grow at least one layer of the buffers they were given
+    uint64_t bufferGrowths = 0;
+};
+
+// Free lists of ChunkMesh objects and CPU side mesh buffers shared by the mesh build threads.
+//
+// Buffers keep their capacity while pooled, so a build reuses vectors sized by earlier builds
+// instead of growing new ones from empty. Buffers are returned as soon as a mesh is uploaded and
+// meshes once they are replaced or dropped, which keeps allocations per rebuild close to zero
+// once the pool has warmed up.
+class ChunkMeshPool
+{
+public:
+    static const size_t MAX_POOLED_MESHES = 512;
+    static const size_t MAX_POOLED_BUFFERS = 128;
+    // pooled buffers that grew larger than this are freed instead, so one very dense chunk
+    // does not keep a large allocation alive
+    static const size_t MAX_POOLED_BUFFER_BYTES = 4 * 1024 * 1024;
+
+    ChunkMeshPool() = default;
+
+    ChunkMeshPool(const ChunkMeshPool&) = delete;
+    ChunkMeshPool& operator=(const ChunkMeshPool&) = delete;
+
+    // returns an empty mesh holding a set of recycled buffers. Safe to call from any thread
+    std::shared_ptr<ChunkMesh> acquire();
+
+    // recycles the mesh if nothing else references it. The mesh must no longer be drawn
+    void release(std::shared_ptr<ChunkMesh>&& mesh);
+    // recycles the CPU side buffers of an uploaded mesh
+    void releaseBuffers(ChunkMesh& mesh);
+
+    // records whether a build had to grow the buffers it was given
+    void recordBuild(bool grewBuffers);
+
+    void clear();
+
+    ChunkMeshPoolStats getStats() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::shared_ptr<ChunkMesh>> m_meshes;
+    std::vector<ChunkMeshBuffers> m_buffers;
+
+    std::atomic<uint64_t> m_builds = 0;
+    std::atomic<uint64_t> m_meshAllocations = 0;
+    std::atomic<uint64_t> m_bufferAllocations = 0;
+    std::atomic<uint64_t> m_bufferGrowths = 0;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include "world/chunk.h"
+#include "world/block_data.h"
+
+// Which faces of a chunk can see each other through connected non-opaque blocks.
+//
+// Computed by flood filling the non-opaque blocks touching the chunk's faces. Every face
+// reached by the same fill is connected to every other face it reached. The frustum search
+// only leaves a chunk through faces connected to the one it entered through, which skips
+// chunks hidden behind solid ground.
+class ChunkVisibility
+{
+public:
+    static const int FACE_COUNT = 6;
+
+    // every face is connected, used for chunks that have not been meshed yet
+    static ChunkVisibility allVisible();
+
+    void compute(const Chunk& chunk);
+
+    bool canSeeThrough(BlockFace from, BlockFace to) const;
+    // true when no face can see any other face, so the chunk hides everything behind it
+    bool isOpaque() const;
+    void connect(BlockFace a, BlockFace b);
+
+    static BlockFace opposite(BlockFace face) { return static_cast<BlockFace>(static_cast<int>(face) ^ 1); }
+
+private:
+    // bit from * FACE_COUNT + to is set when the two faces are connected
+    uint64_t m_connections = 0;
+};
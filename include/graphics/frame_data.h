@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// Per frame camera and lighting state shared by every program through one std140 uniform block.
+// GLSL_BLOCK is the only declaration of the block, ResourceLoader prepends it to every shader
+struct FrameData
+{
+    static const unsigned int BINDING = 0;
+    static constexpr const char* BLOCK_NAME = "FrameData";
+    // must list the members below in the same order
+    static constexpr const char* GLSL_BLOCK =
+        "layout(std140) uniform FrameData\n"
+        "{\n"
+        "    mat4 uView;\n"
+        "    mat4 uProjection;\n"
+        "    mat4 uViewProj;\n"
+        "    mat4 uInvViewProj;\n"
+        "    vec4 uCameraPos;\n"
+        "    vec2 uResolution;\n"
+        "    float uDayNightFrac;\n"
+        "    float uAOIntensity;\n"
+        "    int uAOEnabled;\n"
+        "};\n";
+
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::mat4 viewProjection{1.0f};
+    glm::mat4 invViewProjection{1.0f};
+    // xyz: camera position
+    glm::vec4 cameraPos{0.0f};
+    glm::vec2 resolution{0.0f};
+    float dayNightFrac = 0.5f;
+    float aoIntensity = 1.0f;
+    int aoEnabled = 1;
+    float padding[3]{};
+};
+
+static_assert(offsetof(FrameData, cameraPos) == 256, "FrameData does not match the std140 layout");
+static_assert(offsetof(FrameData, resolution) == 272, "FrameData does not match the std140 layout");
+static_assert(offsetof(FrameData, aoEnabled) == 288, "FrameData does not match the std140 layout");
+static_assert(sizeof(FrameData) % 16 == 0, "FrameData does not match the std140 layout");
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+namespace gfx
+{
+    // A single GL buffer that is sub-allocated into many smaller blocks.
+    // Sizes and offsets are in elements of a fixed size so offsets can be used
+    // directly as base vertices / first indices.
+    // Blocks are referred to by handles so they can be moved when the arena
+    // grows or is compacted.
+    class BufferArena
+    {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle INVALID_HANDLE = 0xFFFFFFFF;
+
+        BufferArena() = default;
+        ~BufferArena();
+
+        BufferArena(const BufferArena&) = delete;
+        BufferArena& operator=(const BufferArena&) = delete;
+        BufferArena(BufferArena&& other) noexcept;
+        BufferArena& operator=(BufferArena&& other) noexcept;
+
+        // every block size is rounded up to a multiple of the alignment, which keeps all offsets aligned
+        void setup(size_t elementSize, size_t initialCapacity, size_t alignment = 1, GLenum usage = GL_DYNAMIC_DRAW);
+
+        // first fit allocation. If no free block is large enough the arena is compacted,
+        // or grown if compacting would not free enough space. Both replace the GL buffer.
+        Handle allocate(size_t count);
+        void upload(Handle handle, const void* data, size_t count);
+        // copies up to count elements of a block back into data. Waits for the GPU to finish
+        // writing the buffer, so it is meant for occasional reads
+        void download(Handle handle, void* data, size_t count) const;
+        // only updates the free list, so it is safe to call without a GL context
+        void free(Handle handle);
+
+        // moves all blocks to the start of the buffer if the free space is fragmented enough
+        bool defragment();
+        void compact();
+
+        void destroy();
+
+        size_t getOffset(Handle handle) const { return m_blocks[handle].offset; }
+        size_t getSize(Handle handle) const { return m_blocks[handle].size; }
+
+        unsigned int getID() const { return m_id; }
+        size_t getElementSize() const { return m_elementSize; }
+        size_t getAlignment() const { return m_alignment; }
+        size_t getCapacity() const { return m_capacity; }
+        size_t getUsed() const { return m_used; }
+        size_t getFreeBlockCount() const { return m_freeBlocks.size(); }
+        size_t getLargestFreeBlock() const;
+
+    private:
+        struct Block
+        {
+            size_t offset = 0;
+            size_t size = 0;
+            bool used = false;
+        };
+
+        unsigned int m_id = 0;
+        size_t m_elementSize = 0;
+        size_t m_alignment = 1;
+        size_t m_capacity = 0;
+        size_t m_used = 0;
+        GLenum m_usage = GL_DYNAMIC_DRAW;
+
+        // indexed by handle
+        std::vector<Block> m_blocks;
+        std::vector<Handle> m_freeHandles;
+        // offset -> size, ordered by offset so neighbouring blocks can be merged
+        std::map<size_t, size_t> m_freeBlocks;
+
+        bool allocateFromFreeList(size_t count, size_t* outOffset);
+        void reallocate(size_t newCapacity);
+    };
+}
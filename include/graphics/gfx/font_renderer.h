@@ -1,16 +1,31 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <array>
 #include <glm/glm.hpp>
 #include <memory>
+#include <vector>
+#include <algorithm>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include "texture_atlas.h"
-#include "mesh.h"
+#include "stream_buffer.h"
 
 namespace gfx
 {
+    // a rasterized glyph and its metrics, which can be cached and added back without FreeType
+    struct Glyph
+    {
+        wchar_t character = 0;
+        glm::ivec2 size{0};
+        glm::ivec2 bearing{0};
+        unsigned int advance = 0;
+        // size.x * size.y coverage values, empty for glyphs without a bitmap such as spaces
+        std::vector<unsigned char> bitmap;
+    };
+
     class FontRenderer
     {
     public:
@@ -30,29 +45,70 @@ namespace gfx
         void preloadGlyphs(const std::string& text);
         void preloadDefaultGlyphs();
 
-        void beginBatch();
-        
-        void addText(const std::wstring& text, float x, float y, float scale, const glm::vec4& color, bool center = false);
-        void addText(const std::wstring& text, float x, float y, float z, float scale, const glm::vec4& color, bool center = false);
-        void addText(const std::wstring& text, const glm::vec3& pos, float scale, const glm::vec4& color, bool center = false);
-        void addText(const std::string& text, float x, float y, float scale, const glm::vec4& color, bool center = false);
-        void addText(const std::string& text, float x, float y, float z, float scale, const glm::vec4& color, bool center = false);
-        void addText(const std::string& text, const glm::vec3& pos, float scale, const glm::vec4& color, bool center = false);
+        // rasterizes the glyphs that are not loaded yet without adding them
+        std::vector<Glyph> rasterizeGlyphs(const std::wstring& text);
+        void addGlyphs(const std::vector<Glyph>& glyphs);
+        static const std::wstring& getDefaultGlyphs();
+
+        // starts a new batch. The vertex storage keeps its capacity between batches, so a batch of
+        // similar size every frame does not allocate. expectedGlyphs reserves room up front
+        void beginBatch(size_t expectedGlyphs = 0);
+
+        // narrow strings are read as Latin-1, one byte per character
+        void addText(std::string_view text, float x, float y, float scale, const glm::vec4& color, bool center = false);
+        void addText(std::string_view text, float x, float y, float z, float scale, const glm::vec4& color, bool center = false);
+        void addText(std::string_view text, const glm::vec3& pos, float scale, const glm::vec4& color, bool center = false);
+        void addText(std::wstring_view text, float x, float y, float scale, const glm::vec4& color, bool center = false);
+        void addText(std::wstring_view text, float x, float y, float z, float scale, const glm::vec4& color, bool center = false);
+        void addText(std::wstring_view text, const glm::vec3& pos, float scale, const glm::vec4& color, bool center = false);
+        void addText(std::u32string_view text, float x, float y, float scale, const glm::vec4& color, bool center = false);
+        void addText(std::u32string_view text, float x, float y, float z, float scale, const glm::vec4& color, bool center = false);
+        void addText(std::u32string_view text, const glm::vec3& pos, float scale, const glm::vec4& color, bool center = false);
 
         // Billboarded text
-        void addTextBB(const std::wstring& text, const glm::vec3& pos, const glm::vec3& center, float scale, const glm::vec4& color, bool textCentered = false);
-        void addTextBB(const std::string& text, const glm::vec3& pos, const glm::vec3& center, float scale, const glm::vec4& color, bool textCentered = false);
+        void addTextBB(std::string_view text, const glm::vec3& pos, const glm::vec3& center, float scale, const glm::vec4& color, bool textCentered = false);
+        void addTextBB(std::wstring_view text, const glm::vec3& pos, const glm::vec3& center, float scale, const glm::vec4& color, bool textCentered = false);
+        void addTextBB(std::u32string_view text, const glm::vec3& pos, const glm::vec3& center, float scale, const glm::vec4& color, bool textCentered = false);
 
         void clearText();
 
         void draw(bool bindVAO = true);
 
+        size_t getGlyphCount() const { return m_glyphCount; }
+
         TextureAtlas<wchar_t>& getTextureAtlas() { return m_textureAtlas; }
 
     private:
+        // Latin-1 glyphs are looked up by index, everything else goes through the overflow map
+        static const size_t DIRECT_GLYPHS = 256;
+
+        // a loaded glyph. The atlas rect is kept in texels because expanding the atlas rescales uvs
+        struct GlyphInfo
+        {
+            glm::vec2 size{0.0f};
+            glm::vec2 bearing{0.0f};
+            float advance = 0.0f;
+            glm::vec2 texelMin{0.0f};
+            glm::vec2 texelMax{0.0f};
+            bool loaded = false;
+            // false for glyphs that only advance, such as spaces
+            bool hasBitmap = false;
+        };
+
         void initFTLib();
         void load(const std::string& fontPath, unsigned int fontSize);
-        bool setupGlyph(wchar_t character, FT_GlyphSlot glyph);
+        static Glyph makeGlyph(char32_t character, FT_GlyphSlot slot);
+        const GlyphInfo* findGlyph(char32_t character) const;
+        // rasterizes the glyph if it is not loaded yet. Returns nullptr if the font cannot render it
+        const GlyphInfo* getGlyph(char32_t character);
+        // the atlas upload expects GL_UNPACK_ALIGNMENT to be 1
+        bool addGlyph(const Glyph& glyph);
+        void ensureQuadIndices();
+        // fixes the uvs already in the batch after the atlas expanded
+        void rescaleBatchTexCoords(const glm::vec2& scale);
+
+        template<typename CharT>
+        void appendText(std::basic_string_view<CharT> text, const glm::vec3& pos, const glm::vec3* center, float scale, const glm::vec4& color, bool textCentered);
 
         struct Vertex
         {
@@ -69,23 +125,18 @@ namespace gfx
             glm::vec2 texCoords;
         };
 
-        struct Character
-        {
-            glm::ivec2 size;
-            glm::ivec2 bearing;
-            unsigned int advance;
-        };
-
         unsigned int m_fontSize = 0;
+        // four vertices per glyph. The index buffer holds a fixed quad pattern that only
+        // grows, so only vertices are streamed each frame
         std::vector<Vertex> m_vertices;
         std::vector<VertexBB> m_verticesBB;
-        std::vector<unsigned int> m_indices;
-        unsigned int m_curVertex = 0;
-        unsigned int m_curIndex = 0;
+        size_t m_glyphCount = 0;
+        size_t m_quadIndexCapacity = 0;
 
         TextureAtlas<wchar_t> m_textureAtlas;
-        std::unordered_map<wchar_t, Character> m_characters;
-        Mesh m_batchMesh;
+        std::array<GlyphInfo, DIRECT_GLYPHS> m_directGlyphs{};
+        std::unordered_map<char32_t, GlyphInfo> m_overflowGlyphs;
+        StreamBuffer m_stream;
         bool m_meshInitialized = false;
         bool m_useBillboard = false;
 
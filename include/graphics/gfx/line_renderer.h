@@ -2,7 +2,7 @@
 
 #include <glm/glm.hpp>
 #include <vector>
-#include "mesh.h"
+#include "stream_buffer.h"
 
 namespace gfx
 {
@@ -32,11 +32,13 @@ namespace gfx
         };
 
         std::vector<Vertex> m_vertices;
-        std::vector<unsigned int> m_indices;
         unsigned int m_curVertex = 0;
-        unsigned int m_curIndex = 0;
+        // lines in the index buffer. Every line uses the same index pattern, so it only grows
+        size_t m_lineIndexCapacity = 0;
 
-        Mesh m_mesh;
+        StreamBuffer m_stream;
         bool m_meshInitialized = false;
+
+        void ensureLineIndices(size_t lineCount);
     };
 }
\ No newline at end of file
@@ -25,6 +25,7 @@ namespace gfx
             GLuint eboHint = GL_STATIC_DRAW
         );
 
+        // uploads the first vertCount floats of vertices
         void updateVertexBuffer(
             const std::vector<float> &vertices, 
             unsigned int vertCount, 
@@ -55,13 +56,17 @@ namespace gfx
         void draw(int indexCount) const;
 
         void destroy();
+
+        unsigned int getIndexCount() const { return m_indexCount; }
     private:
         unsigned int m_vao = 0;
         unsigned int m_vbo = 0;
         unsigned int m_ebo = 0;
         
-        std::vector<float> m_vertices;
-        std::vector<unsigned int> m_indices;
+        // only the sizes are kept on the CPU, the data itself lives in the GL buffers
+        size_t m_vertexBufferSize = 0;
+        size_t m_indexBufferSize = 0;
+        unsigned int m_indexCount = 0;
 
         GLuint m_vboHint = GL_STATIC_DRAW;
         GLuint m_eboHint = GL_STATIC_DRAW;
@@ -2,10 +2,20 @@
 
 #include <glm/glm.hpp>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
+#include <cstdint>
 
 namespace gfx
 {
+    // GLSL source of every stage of a program. An empty geometry source means there is no geometry stage
+    struct ShaderSources
+    {
+        std::string vertex;
+        std::string fragment;
+        std::string geometry;
+    };
+
     class Shader
     {
     public:
@@ -19,6 +29,14 @@ namespace gfx
         Shader& operator=(Shader&& other) noexcept;
 
         void loadFromFile(const std::string& vertPath, const std::string& fragPath, const std::string& geomPath=std::string());
+        // compiles already read sources. Only this step needs the GL context, so the file reads
+        // in readSources can run on another thread
+        void loadFromSource(const ShaderSources& sources);
+        static ShaderSources readSources(const std::string& vertPath, const std::string& fragPath, const std::string& geomPath=std::string());
+
+        // linked programs are saved to this directory with glGetProgramBinary and loaded back
+        // instead of compiling when the sources and driver match. An empty path disables the cache
+        static void setBinaryCacheDir(const std::string& dir);
 
         void use();
         void destroy();
@@ -26,24 +44,64 @@ namespace gfx
         unsigned int getID();
 
         int getAttribLocation(const char* name);
+        // locations are resolved once at link time into a table sorted by name. Returns -1 for
+        // names that are not active uniforms, which the location setters silently ignore. Arrays
+        // can be looked up with or without the [0] subscript. Uniforms set every frame should be
+        // looked up once after loading and set through the location overloads
+        int getUniformLocation(std::string_view name) const;
+        // attaches the named uniform block to a uniform buffer binding. Does nothing if the
+        // program has no such block
+        void bindUniformBlock(const char* blockName, unsigned int binding);
 
+        // look the name up on every call, meant for uniforms set once after loading
         void setBool(const char* name, bool value);
         void setInt(const char* name, int value);
         void setFloat(const char* name, float value);
         void setVec2(const char* name, const glm::vec2& value);
         void setVec3(const char* name, const glm::vec3& value);
         void setVec4(const char* name, const glm::vec4& value);
+        void setIntArray(const char* name, const int* values, int count);
+        void setVec4Array(const char* name, const glm::vec4* values, int count);
         void setMat2(const char* name, const glm::mat2& value);
         void setMat3(const char* name, const glm::mat3& value);
         void setMat4(const char* name, const glm::mat4& value);
 
+        void setBool(int location, bool value);
+        void setInt(int location, int value);
+        void setFloat(int location, float value);
+        void setVec2(int location, const glm::vec2& value);
+        void setVec3(int location, const glm::vec3& value);
+        void setVec4(int location, const glm::vec4& value);
+        void setIntArray(int location, const int* values, int count);
+        void setVec4Array(int location, const glm::vec4* values, int count);
+        void setMat2(int location, const glm::mat2& value);
+        void setMat3(int location, const glm::mat3& value);
+        void setMat4(int location, const glm::mat4& value);
+
 
     private:
+        struct UniformLocation
+        {
+            std::string name;
+            int location;
+        };
+
         static void compileShader(int shader);
-        static void linkProgram(int program);
+        static bool linkProgram(int program);
+        static bool supportsProgramBinary();
+        // hash of the sources and the driver, which decides whether a cached binary can be used
+        static uint64_t getBinaryKey(const ShaderSources& sources);
+        static std::string getBinaryPath(uint64_t key);
+
+        bool loadBinary(uint64_t key);
+        void saveBinary(uint64_t key) const;
+        void cacheUniformLocations();
+
+        static std::string s_binaryCacheDir;
 
         unsigned int m_id = 0;
 
-        std::unordered_map<std::string, int> m_uniformLocations;
+        // sorted by name
+        std::vector<UniformLocation> m_uniformLocations;
     };
 }
\ No newline at end of file
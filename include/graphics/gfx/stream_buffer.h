@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include <vector>
+#include <cstddef>
+
+namespace gfx
+{
+    // A vertex buffer for geometry that is rebuilt every frame, such as debug lines and text.
+    //
+    // The buffer is a ring split into SEGMENTS equal parts and every write takes the next free
+    // range, so a write never touches vertices the GPU may still be reading. With GL 4.4 the
+    // buffer is persistently mapped and a fence is placed as each segment is left, which the
+    // next write into that segment waits on. Without it every range is mapped unsynchronized
+    // and the whole buffer is orphaned each time the ring wraps.
+    //
+    // Draws use glDrawElementsBaseVertex, so the index buffer only has to describe the vertices
+    // of one write and can stay the same between frames.
+    class StreamBuffer
+    {
+    public:
+        static const int SEGMENTS = 3;
+        static const size_t DEFAULT_SEGMENT_VERTICES = 16384;
+
+        StreamBuffer() = default;
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+        StreamBuffer(StreamBuffer&&) noexcept;
+        StreamBuffer& operator=(StreamBuffer&&) noexcept;
+
+        // dims are the float components of each vertex attribute, as in Mesh::populate.
+        // The segments grow when a single write does not fit
+        void setup(const std::vector<unsigned int>& dims, size_t segmentVertices = DEFAULT_SEGMENT_VERTICES);
+        // replaces the index buffer. Indices are relative to the start of each write
+        void setIndices(const std::vector<unsigned int>& indices);
+
+        // returns space for vertexCount vertices that must be filled before unmap is called,
+        // or nullptr if the buffer could not be mapped
+        void* map(size_t vertexCount);
+        void unmap();
+        // copies vertexCount vertices in with map and unmap
+        bool write(const void* vertices, size_t vertexCount);
+
+        // draws indexCount indices against the vertices of the last write
+        void draw(int indexCount, bool bindVAO = true) const;
+        void destroy();
+
+        bool isPersistent() const { return m_persistent; }
+        size_t getSegmentVertices() const { return m_segmentVertices; }
+
+    private:
+        unsigned int m_vao = 0;
+        unsigned int m_vbo = 0;
+        unsigned int m_ebo = 0;
+        std::vector<unsigned int> m_dims;
+        size_t m_stride = 0;
+        size_t m_segmentVertices = 0;
+        // ring position in vertices, and the segment it is in
+        size_t m_cursor = 0;
+        int m_segment = 0;
+        size_t m_baseVertex = 0;
+        bool m_persistent = false;
+        bool m_mapped = false;
+        unsigned char* m_persistentData = nullptr;
+        // placed when a segment is left, waited on before it is written again
+        std::array<GLsync, SEGMENTS> m_fences{};
+
+        void createVertexBuffer();
+        void destroyVertexBuffer();
+        void nextSegment();
+        void waitFence(int segment);
+    };
+}
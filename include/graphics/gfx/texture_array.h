@@ -0,0 +1,247 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include <stb_image.h>
+
+namespace gfx
+{
+    struct TextureArrayParams
+    {
+        unsigned int layerWidth = 16;
+        unsigned int layerHeight = 16;
+        unsigned int initialLayers = 16;
+        GLuint internalFilterMin = GL_NEAREST_MIPMAP_LINEAR;
+        GLuint internalFilterMag = GL_NEAREST;
+        GLuint wrapFilter = GL_REPEAT;
+        GLuint internalFormat = GL_SRGB8_ALPHA8;
+        GLuint format = GL_RGBA;
+    };
+
+    // Equally sized textures stored as the layers of a GL_TEXTURE_2D_ARRAY and looked up by key.
+    //
+    // Unlike TextureAtlas every texture has the whole uv space to itself, so it can repeat
+    // across faces larger than a block and its mipmaps never bleed into a neighbouring texture.
+    // Only RGBA8 data is supported. The pixels of every layer are kept on the CPU so the array
+    // can be reallocated with more layers without reading the texture back.
+    template<typename T>
+    class TextureArray
+    {
+    public:
+        TextureArray(const TextureArrayParams& params = {});
+        ~TextureArray();
+
+        TextureArray(const TextureArray& other) = delete;
+        TextureArray(TextureArray&& other) noexcept;
+        TextureArray& operator=(const TextureArray& other) = delete;
+        TextureArray& operator=(TextureArray&& other) noexcept;
+
+        int addImgFromPath(const T& key, const std::string& path);
+        // returns the layer the texture was stored in, or -1 if it could not be added.
+        // data must be width * height RGBA pixels matching the layer size
+        int add(const T& key, const unsigned char* data, unsigned int width, unsigned int height);
+        // returns -1 if the key has no layer
+        int getLayer(const T& key) const;
+        bool has(const T& key) const;
+        int getLayerCount() const { return m_layerCount; }
+
+        // mipmaps are generated for every layer separately and regenerated when layers are added
+        void generateMipmaps(int maxLevel = 4);
+
+        unsigned int getID() const { return m_id; }
+        void use(GLuint textureUnit = 0) const;
+        void destroy();
+
+    private:
+        TextureArrayParams m_params;
+        unsigned int m_id = 0;
+        std::unordered_map<T, int> m_layers;
+        std::vector<unsigned char> m_pixels;
+        int m_layerCount = 0;
+        int m_layerCapacity = 0;
+        // highest mip level generated so far, 0 if mipmaps were never generated
+        int m_maxMipLevel = 0;
+
+        size_t getLayerBytes() const { return static_cast<size_t>(m_params.layerWidth) * m_params.layerHeight * 4; }
+        bool reallocate(int layerCapacity);
+    };
+
+    template<typename T>
+    TextureArray<T>::TextureArray(const TextureArrayParams& params) : m_params(params) {}
+
+    template<typename T>
+    TextureArray<T>::~TextureArray()
+    {
+        destroy();
+    }
+
+    template<typename T>
+    TextureArray<T>::TextureArray(TextureArray&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    template<typename T>
+    TextureArray<T>& TextureArray<T>::operator=(TextureArray&& other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            m_params = other.m_params;
+            m_id = other.m_id;
+            m_layers = std::move(other.m_layers);
+            m_pixels = std::move(other.m_pixels);
+            m_layerCount = other.m_layerCount;
+            m_layerCapacity = other.m_layerCapacity;
+            m_maxMipLevel = other.m_maxMipLevel;
+            other.m_id = 0;
+            other.m_layerCount = 0;
+            other.m_layerCapacity = 0;
+            other.m_maxMipLevel = 0;
+        }
+        return *this;
+    }
+
+    template<typename T>
+    int TextureArray<T>::addImgFromPath(const T& key, const std::string& path)
+    {
+        int width, height, channels;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+        if (!data) {
+            spdlog::error("TextureArray: Failed to load texture from file: {}", path);
+            return -1;
+        }
+
+        int layer = add(key, data, width, height);
+        stbi_image_free(data);
+        return layer;
+    }
+
+    template<typename T>
+    int TextureArray<T>::add(const T& key, const unsigned char* data, unsigned int width, unsigned int height)
+    {
+        if (data == nullptr) {
+            spdlog::warn("TextureArray: Data is null. Cannot add texture.");
+            return -1;
+        }
+        if (m_layers.contains(key)) {
+            spdlog::warn("TextureArray: Texture already exists in array.");
+            return -1;
+        }
+        if (width != m_params.layerWidth || height != m_params.layerHeight) {
+            spdlog::warn("TextureArray: Texture is {}x{} but layers are {}x{}.", width, height, m_params.layerWidth, m_params.layerHeight);
+            return -1;
+        }
+
+        if (m_layerCount == m_layerCapacity) {
+            int newCapacity = std::max<int>(m_params.initialLayers, m_layerCapacity * 2);
+            if (!reallocate(newCapacity)) {
+                spdlog::error("TextureArray: Failed to grow array. Cannot add texture.");
+                return -1;
+            }
+        }
+
+        int layer = m_layerCount++;
+        m_pixels.insert(m_pixels.end(), data, data + getLayerBytes());
+        m_layers[key] = layer;
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_params.layerWidth, m_params.layerHeight, 1, m_params.format, GL_UNSIGNED_BYTE, data);
+        if (m_maxMipLevel > 0)
+            generateMipmaps(m_maxMipLevel);
+        return layer;
+    }
+
+    template<typename T>
+    int TextureArray<T>::getLayer(const T& key) const
+    {
+        auto it = m_layers.find(key);
+        if (it == m_layers.end())
+            return -1;
+        return it->second;
+    }
+
+    template<typename T>
+    bool TextureArray<T>::has(const T& key) const
+    {
+        return m_layers.contains(key);
+    }
+
+    template<typename T>
+    void TextureArray<T>::generateMipmaps(int maxLevel)
+    {
+        if (m_id == 0) {
+            spdlog::warn("TextureArray: Texture array not initialized.");
+            return;
+        }
+        if (m_params.internalFilterMin != GL_LINEAR_MIPMAP_LINEAR &&
+            m_params.internalFilterMin != GL_NEAREST_MIPMAP_LINEAR &&
+            m_params.internalFilterMin != GL_LINEAR_MIPMAP_NEAREST &&
+            m_params.internalFilterMin != GL_NEAREST_MIPMAP_NEAREST) {
+            spdlog::warn("TextureArray: Mipmaps can only be generated with linear or nearest mipmap filters.");
+            return;
+        }
+        m_maxMipLevel = maxLevel;
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, maxLevel);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+
+    template<typename T>
+    void TextureArray<T>::use(GLuint textureUnit) const
+    {
+        if (m_id == 0) {
+            spdlog::warn("TextureArray: Texture array not initialized.");
+            return;
+        }
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    template<typename T>
+    void TextureArray<T>::destroy()
+    {
+        if (m_id != 0) {
+            glDeleteTextures(1, &m_id);
+            m_id = 0;
+        }
+        m_layers.clear();
+        m_pixels.clear();
+        m_layerCount = 0;
+        m_layerCapacity = 0;
+        m_maxMipLevel = 0;
+    }
+
+    template<typename T>
+    bool TextureArray<T>::reallocate(int layerCapacity)
+    {
+        GLint maxLayers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        layerCapacity = std::min(layerCapacity, static_cast<int>(maxLayers));
+        if (layerCapacity <= m_layerCount)
+            return false;
+
+        if (m_id == 0)
+            glGenTextures(1, &m_id);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+        // respecifying level 0 drops the old layers, so they are uploaded again from the CPU copy
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, m_params.internalFormat, m_params.layerWidth, m_params.layerHeight, layerCapacity, 0, m_params.format, GL_UNSIGNED_BYTE, nullptr);
+        if (m_layerCount > 0)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, m_params.layerWidth, m_params.layerHeight, m_layerCount, m_params.format, GL_UNSIGNED_BYTE, m_pixels.data());
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, m_params.internalFilterMin);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, m_params.internalFilterMag);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, m_params.wrapFilter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, m_params.wrapFilter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_maxMipLevel);
+
+        m_layerCapacity = layerCapacity;
+        return true;
+    }
+}
@@ -47,7 +47,7 @@ namespace gfx
 
         // returns the uv coordinates of the texture in the atlas (topleft, bottomright)
         // returns {0,0} if the texture was not added successfully
-        std::pair<glm::vec2, glm::vec2> add(const T& key, unsigned char* data, unsigned int width, unsigned int height);
+        std::pair<glm::vec2, glm::vec2> add(const T& key, const unsigned char* data, unsigned int width, unsigned int height);
         std::pair<glm::vec2, glm::vec2> get(const T& key) const;
 
         void generateMipmaps(int maxLevel = 4);
@@ -57,6 +57,9 @@ namespace gfx
         bool has(const T& key) const;
 
         unsigned int getID() const { return m_id; }
+        // the size changes when the atlas expands, which rescales every uv it handed out
+        int getWidth() const { return m_width; }
+        int getHeight() const { return m_height; }
         void use() const;
         void destroy();
     private:
@@ -191,7 +194,7 @@ namespace gfx
     // returns the uv coordinates of the texture in the atlas (topleft, bottomright)
     // returns {0,0} if the texture was not added successfully
     template<typename T>
-    std::pair<glm::vec2, glm::vec2> TextureAtlas<T>::add(const T& key, unsigned char* data, unsigned int width, unsigned int height) {
+    std::pair<glm::vec2, glm::vec2> TextureAtlas<T>::add(const T& key, const unsigned char* data, unsigned int width, unsigned int height) {
         if (!m_initialized) {
             init();
         }
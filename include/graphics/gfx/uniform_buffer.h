@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+
+namespace gfx
+{
+    // A uniform buffer bound to a fixed binding point. Programs see it once their uniform block
+    // is attached to the same binding with Shader::bindUniformBlock
+    class UniformBuffer
+    {
+    public:
+        UniformBuffer() = default;
+        ~UniformBuffer();
+
+        UniformBuffer(const UniformBuffer&) = delete;
+        UniformBuffer& operator=(const UniformBuffer&) = delete;
+        UniformBuffer(UniformBuffer&&) noexcept;
+        UniformBuffer& operator=(UniformBuffer&&) noexcept;
+
+        void setup(size_t size, unsigned int binding);
+        // replaces the contents from offset. The whole buffer is orphaned when size covers all of it
+        void update(const void* data, size_t size, size_t offset = 0);
+        void bind() const;
+        void destroy();
+
+        unsigned int getID() const { return m_id; }
+        size_t getSize() const { return m_size; }
+        unsigned int getBinding() const { return m_binding; }
+
+    private:
+        unsigned int m_id = 0;
+        size_t m_size = 0;
+        unsigned int m_binding = 0;
+    };
+}
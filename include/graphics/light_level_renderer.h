@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <chrono>
+#include "world/chunk_map.h"
+#include "graphics/gfx/shader.h"
+
+// Draws the sun or block light level of every air block around the camera as billboarded numbers.
+//
+// Each number is one instance of a quad whose digits are read from a tiny 3x5 digit texture, so
+// the whole overlay is a single draw call. Instances are rebuilt from a scan over the flat chunk
+// arrays only when the camera enters another block, the options change, or REFRESH_MS has passed
+// so edited light still shows up.
+class LightLevelRenderer
+{
+public:
+    static constexpr float REFRESH_MS = 250.0f;
+    // height of a digit in blocks
+    static constexpr float DIGIT_HEIGHT = 0.12f;
+
+    LightLevelRenderer() = default;
+    ~LightLevelRenderer();
+
+    LightLevelRenderer(const LightLevelRenderer&) = delete;
+    LightLevelRenderer& operator=(const LightLevelRenderer&) = delete;
+
+    void setup(gfx::Shader* shader);
+    // the camera matrices come from the FrameData uniform block
+    void draw(const ChunkMap& chunkMap, const glm::vec3& cameraPos, int radius, bool showSunLight, bool showBlockLight);
+    void destroy();
+
+    size_t getInstanceCount() const { return m_instances.size(); }
+
+private:
+    struct Instance
+    {
+        glm::vec3 center;
+        uint32_t level;
+    };
+
+    gfx::Shader* m_shader = nullptr;
+    unsigned int m_vao = 0;
+    unsigned int m_instanceBuffer = 0;
+    unsigned int m_digitTexture = 0;
+    std::vector<Instance> m_instances;
+
+    // inputs of the last rebuild
+    glm::ivec3 m_cameraBlock{0};
+    int m_radius = -1;
+    bool m_showSunLight = false;
+    bool m_showBlockLight = false;
+    std::chrono::steady_clock::time_point m_rebuildTime;
+
+    void rebuildInstances(const ChunkMap& chunkMap);
+};
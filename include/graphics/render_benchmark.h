@@ -0,0 +1,114 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "camera.h"
+#include "graphics/world_renderer.h"
+#include "graphics/gfx/font_renderer.h"
+
+// a set of render options to fly the benchmark path with
+struct RenderBenchmarkVariant
+{
+    std::string name;
+    RenderOptions renderOptions;
+};
+
+struct RenderBenchmarkResult
+{
+    std::string name;
+    int frames = 0;
+    float avgFrameMs = 0.0f;
+    float maxFrameMs = 0.0f;
+    float avgDrawnChunks = 0.0f;
+    // arena bytes used by the meshes around the start of the path
+    size_t arenaBytes = 0;
+};
+
+struct FrustumCullBenchmarkResult
+{
+    int boxCount = 0;
+    int visibleCount = 0;
+    // average time to cull every box once
+    float perBoxMs = 0.0f;
+    float batchMs = 0.0f;
+};
+
+struct TextBatchBenchmarkResult
+{
+    int glyphCount = 0;
+    // glyphs that ended up in the batch, fewer than glyphCount if the font lacks some of them
+    int batchedGlyphs = 0;
+    float avgBatchMs = 0.0f;
+    float maxBatchMs = 0.0f;
+};
+
+// times batching glyphCount glyphs of short labels into fontRenderer once per iteration, the way a
+// frame full of text would. A warm up batch runs first so glyph loading and buffer growth are not
+// counted. Only the CPU side is measured, the batch is not drawn
+TextBatchBenchmarkResult benchmarkTextBatching(gfx::FontRenderer& fontRenderer, int glyphCount = 100000, int iterations = 20);
+
+struct RayCastBenchmarkResult
+{
+    int rayCount = 0;
+    float maxDistance = 0.0f;
+    int hits = 0;
+    // algo::voxelRayHit reading blocks through ChunkMap::getBlock
+    float functionMs = 0.0f;
+    // algo::voxelRayCasts reading blocks through a ChunkMap::BlockCursor
+    float cursorMs = 0.0f;
+    int cursorChunkLookups = 0;
+};
+
+// casts rayCount rays in random directions from origin against the solid blocks of chunkMap, once
+// one ray at a time through std::function and ChunkMap::getBlock and once as a batch through a
+// block cursor. Short rays match block picking, long ones line of sight checks
+RayCastBenchmarkResult benchmarkRayCasting(const ChunkMap& chunkMap, const glm::vec3& origin, float maxDistance, int rayCount = 10000);
+
+// times Frustum::intersectsAABB one box at a time against Frustum::intersectsAABBs over the same
+// randomly placed chunk sized boxes around center. The boxes come from a fixed seed
+FrustumCullBenchmarkResult benchmarkFrustumCulling(const Frustum& frustum, const glm::vec3& center, int boxCount = 30000, int iterations = 100);
+
+// Flies the camera along a fixed path once for every variant and records the frame times and
+// drawn chunks, so render options can be compared on the same seed and view. Each run starts
+// by waiting for the meshes around the start position to finish building and uploading.
+class RenderBenchmark
+{
+public:
+    static constexpr float SETTLE_TIMEOUT = 30.0f;
+    static constexpr float PATH_DURATION = 20.0f;
+    static constexpr float PATH_SPEED = 20.0f;
+    static constexpr float PATH_YAW_SPEED = 18.0f;
+
+    // the path starts at the current camera position. The current render options are restored once every variant has run
+    void start(const Camera& camera, const RenderOptions& renderOptions, std::vector<RenderBenchmarkVariant> variants);
+    // moves the camera along the path. Must be called once per frame before the world renderer updates
+    void update(Camera& camera, WorldRenderer& worldRenderer, float deltaTime);
+
+    bool isRunning() const { return m_stage != Stage::Idle; }
+    const std::vector<RenderBenchmarkResult>& getResults() const { return m_results; }
+
+private:
+    enum class Stage
+    {
+        Idle,
+        Settling,
+        Flying
+    };
+
+    Stage m_stage = Stage::Idle;
+    std::vector<RenderBenchmarkVariant> m_variants;
+    int m_variantIndex = 0;
+    float m_stageTime = 0.0f;
+    float m_totalFrameMs = 0.0f;
+    size_t m_totalDrawnChunks = 0;
+    glm::vec3 m_startPosition{0.0f};
+    float m_startYaw = Camera::DEFAULT_YAW;
+    float m_startPitch = Camera::DEFAULT_PITCH;
+    RenderOptions m_prevRenderOptions;
+    RenderBenchmarkResult m_current;
+    std::vector<RenderBenchmarkResult> m_results;
+
+    void startVariant(Camera& camera, WorldRenderer& worldRenderer);
+    void setCamera(Camera& camera, float pathTime);
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include "camera.h"
+#include "resource_manager.h"
+#include "world/chunk_map.h"
+#include "graphics/world_renderer.h"
+#include "graphics/render_benchmark.h"
+
+// ImGui widgets for the chunk renderer statistics, the culling toggles and the benchmarks.
+// Owns the render benchmark and keeps the results of the one shot benchmarks between frames
+class RenderDebugPanel
+{
+public:
+    // adds the widgets to the current ImGui window
+    void draw(WorldRenderer& worldRenderer, const Camera& camera, const ChunkMap& chunkMap, ResourceManager& resourceManager);
+
+    RenderBenchmark& getRenderBenchmark() { return m_renderBenchmark; }
+    const RenderBenchmark& getRenderBenchmark() const { return m_renderBenchmark; }
+
+private:
+    RenderBenchmark m_renderBenchmark;
+    FrustumCullBenchmarkResult m_frustumCullBenchmark;
+    TextBatchBenchmarkResult m_textBatchBenchmark;
+    std::vector<RayCastBenchmarkResult> m_rayCastBenchmarks;
+
+    void drawStats(WorldRenderer& worldRenderer);
+    void drawBenchmarks(WorldRenderer& worldRenderer, const Camera& camera, const ChunkMap& chunkMap, ResourceManager& resourceManager);
+};
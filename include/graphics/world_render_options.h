@@ -4,7 +4,19 @@
 
 struct RenderOptions
 {
+    static const int DEFAULT_LOD_DISTANCE = 16;
+    // Upper bound on meshes that are queued, being built, or waiting to be submitted.
+    // Chunks queued due to block updates are always added to the front of the queue
+    // and may cause the number of meshes in flight to exceed this value.
+    // This value is primarily used to limit the number of chunks queued from the frustum
+    // to allow for a more responsive frustum queueing.
+    static const int DEFAULT_MAX_BUILDS_IN_FLIGHT = 64;
+    static const int DEFAULT_UPLOAD_BUDGET_KB = 4096;
+    static constexpr float DEFAULT_UPLOAD_BUDGET_MS = 2.0f;
+
     int renderDistance = 8;
+    // chunks get one level of detail coarser every lodDistance chunks, 0 disables levels of detail
+    int lodDistance = DEFAULT_LOD_DISTANCE;
     bool useAO = true;
     bool useSmoothLighting = true;
     bool showChunkBorder = false;
@@ -12,4 +24,15 @@ struct RenderOptions
     bool showBlockLightLevels = false;
     float showLightLevelRadius = Chunk::CHUNK_SIZE / 2;
     float aoFactor = 0.5f;
+    // 0 picks a thread count based on the available hardware threads
+    int meshBuildThreads = 0;
+    int maxMeshesInFlight = DEFAULT_MAX_BUILDS_IN_FLIGHT;
+    int meshUploadBudgetKB = DEFAULT_UPLOAD_BUDGET_KB;
+    float meshUploadBudgetMs = DEFAULT_UPLOAD_BUDGET_MS;
+    // store one record per face and expand it into a quad in the vertex shader
+    bool useFacePulling = false;
+    // skip chunks that cannot be seen through the chunks between them and the camera
+    bool useCaveCulling = true;
+    // skip chunks hidden behind opaque chunks closer to the camera
+    bool useOcclusionCulling = true;
 };
\ No newline at end of file
@@ -4,7 +4,10 @@
 #include "camera.h"
 #include "world/chunk_map.h"
 #include "graphics/chunk_map_renderer.h"
+#include "graphics/light_level_renderer.h"
 #include "graphics/world_render_options.h"
+#include "graphics/frame_data.h"
+#include "graphics/gfx/uniform_buffer.h"
 #include "game_window.h"
 
 class WorldRenderer
@@ -19,22 +22,32 @@ public:
     WorldRenderer(const WorldRenderer&) = delete;
     WorldRenderer& operator=(const WorldRenderer&) = delete;
 
-    void update();
+    void update(const Camera& camera);
 
     void loadResources();
 
-    void draw(const Camera& camera, GameWindow& window, float dayNightFrac);
+    // uploads the FrameData block every program reads its camera and lighting state from.
+    // Must be called once per frame before anything in the world is drawn
+    void updateFrameData(const Camera& camera, float dayNightFrac);
 
-    void highlightVoxels(const std::vector<glm::ivec3>& voxels, const Camera &camera, GameWindow& window);
-    void showFrustum(const glm::mat4& mat, const Camera& camera, GameWindow& window);
+    void draw(const Camera& camera, GameWindow& window);
+
+    void highlightVoxels(const std::vector<glm::ivec3>& voxels, GameWindow& window);
+    void showFrustum(const glm::mat4& mat, GameWindow& window);
 
     ChunkMapRenderer& getChunkMapRenderer() { return m_chunkMapRenderer; }
+    const LightLevelRenderer& getLightLevelRenderer() const { return m_lightLevelRenderer; }
 private:
     ChunkMap* m_chunkMap = nullptr;
     ResourceManager* m_resourceManager = nullptr;
     ChunkMapRenderer m_chunkMapRenderer;
+    LightLevelRenderer m_lightLevelRenderer;
+    FrameData m_frameData;
+    gfx::UniformBuffer m_frameDataBuffer;
+    // resolved in loadResources, the overlays set it on every draw
+    int m_lineWidthLocation = -1;
 
     void checkPointers() const;
-    void drawChunkBorder(const glm::ivec3& chunkPos, const Camera& camera, GameWindow& window);
+    void drawChunkBorder(const glm::ivec3& chunkPos, GameWindow& window);
     void showLightLevels(const Camera& camera);
 };
\ No newline at end of file
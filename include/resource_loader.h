@@ -2,7 +2,13 @@
 
 #include <string>
 #include <filesystem>
+#include <vector>
+#include <future>
+#include <memory>
+#include <functional>
+#include <chrono>
 #include "resource_manager.h"
+#include "asset_cache.h"
 
 class ResourceLoader
 {
@@ -12,7 +18,30 @@ public:
 
     void load(const glm::ivec2& frameBufferSize);
 private:
+    // CPU side work of loading one asset, run on its own thread. The returned step does the GL
+    // uploads and runs on the main thread once the job is done
+    using DecodeFunc = std::function<std::function<void()>()>;
+    struct AssetJob
+    {
+        std::string label;
+        std::future<std::function<void()>> upload;
+        // time since m_loadStart when the decode finished, written by the job
+        std::shared_ptr<float> decodedAtMs;
+    };
+
     ResourceManager* m_resourceManager = nullptr;
+    std::vector<AssetJob> m_jobs;
+    std::chrono::steady_clock::time_point m_loadStart;
+
+    void launchJob(const std::string& label, DecodeFunc decode);
+    // runs the upload step of each job as soon as it finishes and logs the startup timeline.
+    // Returns the number of jobs that failed and returned no upload step
+    int finishJobs();
+    float getLoadMs() const;
 
-    void setupChunkAtlas();
+    void loadShader(const std::string& name, const std::string& vertPath, const std::string& fragPath);
+    // loads the block textures and font glyphs from the asset cache, or decodes and rasterizes
+    // them in parallel and bakes a new cache if it is missing or out of date
+    void loadCachedAssets();
+    void addBlockTexture(const AssetCache::Texture& texture);
 };
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include "graphics/gfx/font_renderer.h"
 #include "graphics/gfx/line_renderer.h"
 #include "graphics/gfx/texture_atlas.h"
+#include "graphics/gfx/texture_array.h"
 #include "graphics/gfx/render_target.h"
 #include "graphics/gfx/screen_quad.h"
 
@@ -70,6 +71,13 @@ public:
     gfx::TextureAtlas<T>* getTextureAtlas(const std::string& name) const;
     template <typename T>
     void removeTextureAtlas(const std::string& name);
+
+    template <typename T>
+    gfx::TextureArray<T>* addTextureArray(const std::string& name, const gfx::TextureArrayParams& params);
+    template <typename T>
+    gfx::TextureArray<T>* getTextureArray(const std::string& name) const;
+    template <typename T>
+    void removeTextureArray(const std::string& name);
 private:
     std::unordered_map<std::string, std::unique_ptr<gfx::Shader>> m_shaders;
     std::unordered_map<std::string, std::unique_ptr<gfx::Texture>> m_textures;
@@ -79,18 +87,19 @@ private:
     std::unordered_map<std::string, std::unique_ptr<gfx::RenderTarget>> m_renderTargets;
     std::unordered_map<std::string, std::unique_ptr<gfx::ScreenQuad>> m_screenQuads;
     
-    std::unordered_map<std::type_index, std::any> m_textureAtlasTypeMap;
+    // resources templated on their key type, one name map per resource type
+    std::unordered_map<std::type_index, std::any> m_typedResourceMaps;
 
-    template<typename T>
-    std::unordered_map<std::string, std::shared_ptr<gfx::TextureAtlas<T>>>& getTypedMap();
-    template<typename T>
-    const std::unordered_map<std::string, std::shared_ptr<gfx::TextureAtlas<T>>>* getTypedMapPtr() const;
+    template<typename R>
+    std::unordered_map<std::string, std::shared_ptr<R>>& getTypedMap();
+    template<typename R>
+    const std::unordered_map<std::string, std::shared_ptr<R>>* getTypedMapPtr() const;
 };
 
 template <typename T>
 gfx::TextureAtlas<T> *ResourceManager::addTextureAtlas(const std::string &name, const gfx::TextureAtlasParams &params)
 {
-    auto& typedMap = getTypedMap<T>();
+    auto& typedMap = getTypedMap<gfx::TextureAtlas<T>>();
     auto ret = typedMap.try_emplace(name, std::make_shared<gfx::TextureAtlas<T>>(params));
     if (ret.second)
     {
@@ -106,7 +115,7 @@ gfx::TextureAtlas<T> *ResourceManager::addTextureAtlas(const std::string &name,
 template <typename T>
 gfx::TextureAtlas<T> *ResourceManager::addTextureAtlas(const std::string &name, gfx::TextureAtlas<T> &&atlas)
 {
-    auto& typedMap = getTypedMap<T>();
+    auto& typedMap = getTypedMap<gfx::TextureAtlas<T>>();
     auto ret = typedMap.try_emplace(name, std::make_shared<gfx::TextureAtlas<T>>(std::move(atlas)));
     if (ret.second)
     {
@@ -122,7 +131,7 @@ gfx::TextureAtlas<T> *ResourceManager::addTextureAtlas(const std::string &name,
 template <typename T>
 gfx::TextureAtlas<T> *ResourceManager::getTextureAtlas(const std::string &name) const
 {
-    auto typedMap = getTypedMapPtr<T>();
+    auto typedMap = getTypedMapPtr<gfx::TextureAtlas<T>>();
     if (typedMap == nullptr)
     {
         spdlog::warn("TextureAtlas with name \"{}\" not found.", name);
@@ -140,26 +149,67 @@ gfx::TextureAtlas<T> *ResourceManager::getTextureAtlas(const std::string &name)
 template <typename T>
 void ResourceManager::removeTextureAtlas(const std::string &name)
 {
-    auto& typedMap = getTypedMap<T>();
+    auto& typedMap = getTypedMap<gfx::TextureAtlas<T>>();
+    typedMap.erase(name);
+}
+
+template <typename T>
+gfx::TextureArray<T> *ResourceManager::addTextureArray(const std::string &name, const gfx::TextureArrayParams &params)
+{
+    auto& typedMap = getTypedMap<gfx::TextureArray<T>>();
+    auto ret = typedMap.try_emplace(name, std::make_shared<gfx::TextureArray<T>>(params));
+    if (ret.second)
+    {
+        return ret.first->second.get();
+    }
+    else
+    {
+        spdlog::warn("TextureArray with name \"{}\" already exists. Skipping addition.", name);
+        return nullptr;
+    }
+}
+
+template <typename T>
+gfx::TextureArray<T> *ResourceManager::getTextureArray(const std::string &name) const
+{
+    auto typedMap = getTypedMapPtr<gfx::TextureArray<T>>();
+    if (typedMap == nullptr)
+    {
+        spdlog::warn("TextureArray with name \"{}\" not found.", name);
+        return nullptr;
+    }
+    auto it = typedMap->find(name);
+    if (it != typedMap->end())
+    {
+        return it->second.get();
+    }
+    spdlog::warn("TextureArray with name \"{}\" not found.", name);
+    return nullptr;
+}
+
+template <typename T>
+void ResourceManager::removeTextureArray(const std::string &name)
+{
+    auto& typedMap = getTypedMap<gfx::TextureArray<T>>();
     typedMap.erase(name);
 }
 
-template<typename T>
-std::unordered_map<std::string, std::shared_ptr<gfx::TextureAtlas<T>>>& ResourceManager::getTypedMap()
+template<typename R>
+std::unordered_map<std::string, std::shared_ptr<R>>& ResourceManager::getTypedMap()
 {
-    std::type_index index(typeid(T));
-    if (m_textureAtlasTypeMap.find(index) == m_textureAtlasTypeMap.end()) {
-        m_textureAtlasTypeMap[index] = std::unordered_map<std::string, std::shared_ptr<gfx::TextureAtlas<T>>>{};
+    std::type_index index(typeid(R));
+    if (m_typedResourceMaps.find(index) == m_typedResourceMaps.end()) {
+        m_typedResourceMaps[index] = std::unordered_map<std::string, std::shared_ptr<R>>{};
     }
-    return *std::any_cast<std::unordered_map<std::string, std::shared_ptr<gfx::TextureAtlas<T>>>>(&m_textureAtlasTypeMap[index]);
+    return *std::any_cast<std::unordered_map<std::string, std::shared_ptr<R>>>(&m_typedResourceMaps[index]);
 }
 
-template<typename T>
-const std::unordered_map<std::string, std::shared_ptr<gfx::TextureAtlas<T>>>* ResourceManager::getTypedMapPtr() const
+template<typename R>
+const std::unordered_map<std::string, std::shared_ptr<R>>* ResourceManager::getTypedMapPtr() const
 {
-    std::type_index index(typeid(T));
-    if (m_textureAtlasTypeMap.find(index) == m_textureAtlasTypeMap.end()) {
+    std::type_index index(typeid(R));
+    if (m_typedResourceMaps.find(index) == m_typedResourceMaps.end()) {
         return nullptr;
     }
-    return std::any_cast<std::unordered_map<std::string, std::shared_ptr<gfx::TextureAtlas<T>>> const>(&m_textureAtlasTypeMap.at(index));
+    return std::any_cast<std::unordered_map<std::string, std::shared_ptr<R>> const>(&m_typedResourceMaps.at(index));
 }
\ No newline at end of file
@@ -3,6 +3,10 @@
 #include <vector>
 #include <functional>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <limits>
 #include <glm/glm.hpp>
 
 namespace algo
@@ -13,6 +17,67 @@ namespace algo
         glm::ivec3 normal;
     };
 
+    struct VoxelRay
+    {
+        glm::vec3 origin;
+        glm::vec3 dir;
+        float maxDistance = 100.0f;
+    };
+
+    // steps through the voxels along the ray and returns the first one hitCondition accepts, with
+    // the normal of the face the ray entered through. The voxel containing origin is not tested.
+    // A miss returns the last voxel visited with a zero normal.
+    // hitCondition is called as bool(const glm::ivec3&) and is inlined, unlike voxelRayHit
+    template <typename HitFunc>
+    VoxelRayHitNode voxelRayCast(const glm::vec3& origin, const glm::vec3& dir, HitFunc&& hitCondition, float maxDistance = 100.0f)
+    {
+        const float inf = std::numeric_limits<float>::max();
+        glm::ivec3 v = glm::floor(origin);
+        glm::ivec3 step = glm::sign(dir);
+        float tmaxX = dir.x != 0.0f ? (v.x + (step.x > 0 ? 1 : 0) - origin.x) / dir.x : inf;
+        float tmaxY = dir.y != 0.0f ? (v.y + (step.y > 0 ? 1 : 0) - origin.y) / dir.y : inf;
+        float tmaxZ = dir.z != 0.0f ? (v.z + (step.z > 0 ? 1 : 0) - origin.z) / dir.z : inf;
+
+        float tDeltaX = step.x != 0 ? std::abs(1.0f / dir.x) : inf;
+        float tDeltaY = step.y != 0 ? std::abs(1.0f / dir.y) : inf;
+        float tDeltaZ = step.z != 0 ? std::abs(1.0f / dir.z) : inf;
+
+        glm::ivec3 hitNormal(0);
+        float tTotal = std::min({tmaxX, tmaxY, tmaxZ});
+
+        while (tTotal < maxDistance) {
+            if (tmaxX < tmaxY && tmaxX < tmaxZ) {
+                v.x += step.x;
+                tmaxX += tDeltaX;
+                hitNormal = glm::ivec3(-step.x, 0, 0);
+            } else if (tmaxY < tmaxZ) {
+                v.y += step.y;
+                tmaxY += tDeltaY;
+                hitNormal = glm::ivec3(0, -step.y, 0);
+            } else {
+                v.z += step.z;
+                tmaxZ += tDeltaZ;
+                hitNormal = glm::ivec3(0, 0, -step.z);
+            }
+            tTotal = std::min({tmaxX, tmaxY, tmaxZ});
+
+            if (hitCondition(v)) {
+                return {v, hitNormal};
+            }
+        }
+        return {v, glm::ivec3(0)}; // No hit found
+    }
+
+    // casts every ray with voxelRayCast into results, in the same order. The same hitCondition
+    // is used for every ray, so state it keeps such as a cached chunk carries over between rays
+    template <typename HitFunc>
+    void voxelRayCasts(const std::vector<VoxelRay>& rays, HitFunc&& hitCondition, std::vector<VoxelRayHitNode>& results)
+    {
+        results.resize(rays.size());
+        for (size_t i = 0; i < rays.size(); ++i)
+            results[i] = voxelRayCast(rays[i].origin, rays[i].dir, hitCondition, rays[i].maxDistance);
+    }
+
     VoxelRayHitNode voxelRayHit(
         const glm::vec3& origin, 
         const glm::vec3& dir, 
@@ -26,4 +91,37 @@ namespace algo
         float maxDistance=100.0f);
 
     std::vector<glm::ivec3> getPosFromCenter(const glm::ivec3& center, int radius);
+
+    static constexpr uint64_t FNV1A_OFFSET = 14695981039346656037ull;
+
+    // 64 bit FNV-1a. Pass the previous result as hash to continue hashing over several buffers
+    uint64_t fnv1a(const void* data, size_t size, uint64_t hash = FNV1A_OFFSET);
+
+    // stable LSD radix sort of items by an unsigned 32 bit key, 8 bits per pass. Passes where
+    // every key has the same byte are skipped, so small keys only cost one or two passes.
+    // scratch is resized to match items and can be kept around to avoid reallocating
+    template <typename T, typename KeyFunc>
+    void radixSort(std::vector<T>& items, std::vector<T>& scratch, KeyFunc key)
+    {
+        scratch.resize(items.size());
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            std::array<size_t, 256> counts{};
+            for (const T& item : items)
+                ++counts[(static_cast<uint32_t>(key(item)) >> shift) & 0xFF];
+            if (std::find(counts.begin(), counts.end(), items.size()) != counts.end())
+                continue;
+
+            size_t offset = 0;
+            for (size_t& count : counts)
+            {
+                size_t bucketSize = count;
+                count = offset;
+                offset += bucketSize;
+            }
+            for (const T& item : items)
+                scratch[counts[(static_cast<uint32_t>(key(item)) >> shift) & 0xFF]++] = item;
+            items.swap(scratch);
+        }
+    }
 }
\ No newline at end of file
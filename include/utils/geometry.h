@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 #include <array>
+#include <vector>
+#include <cstdint>
 
 struct Plane {
     glm::vec3 normal;
@@ -12,6 +14,19 @@ struct Plane {
     }
 };
 
+// axis aligned boxes stored as separate arrays per component, so several boxes can be
+// loaded into one SIMD register
+struct AABBList
+{
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    void clear();
+    void reserve(size_t count);
+    void push(const glm::vec3& min, const glm::vec3& max);
+    size_t size() const { return minX.size(); }
+};
+
 class Frustum 
 {
 public:
@@ -21,4 +36,51 @@ public:
     Frustum(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix);
 
     bool intersectsAABB(const glm::vec3& min, const glm::vec3& max) const;
-};
\ No newline at end of file
+    // copy with every plane moved outward by distance
+    Frustum padded(float distance) const;
+    // writes the indices of the boxes intersecting the frustum to visibleOut, in order.
+    // Tests 8 boxes at a time with AVX, 4 with SSE, and falls back to scalar code otherwise
+    void intersectsAABBs(const AABBList& boxes, std::vector<uint32_t>& visibleOut) const;
+};
+
+// Low resolution software depth buffer for occlusion culling on the CPU.
+//
+// Occluders are boxes known to be fully opaque. Their camera facing sides are rasterized
+// storing 1/w, which interpolates linearly in screen space, so larger values are closer.
+// A box is hidden when every pixel its screen rect covers holds an occluder closer than
+// the box's nearest corner. Boxes crossing the near plane are always visible.
+// Has no GL dependencies so it can be driven headlessly with synthetic scenes.
+class OcclusionBuffer
+{
+public:
+    static const int DEFAULT_WIDTH = 256;
+    static const int DEFAULT_HEIGHT = 128;
+
+    OcclusionBuffer(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
+
+    void clear(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+    void addOccluder(const glm::vec3& min, const glm::vec3& max);
+    bool isVisible(const glm::vec3& min, const glm::vec3& max) const;
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    const std::vector<float>& getDepth() const { return m_depth; }
+
+private:
+    struct ScreenVertex
+    {
+        float x, y;
+        float invW;
+    };
+
+    int m_width;
+    int m_height;
+    glm::mat4 m_viewProjection{1.0f};
+    glm::vec3 m_cameraPosition{0.0f};
+    // 1/w of the closest occluder of each pixel, 0 where there is none
+    std::vector<float> m_depth;
+
+    // returns false when the point is behind the near plane
+    bool project(const glm::vec3& point, ScreenVertex* out) const;
+    void rasterizeTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c);
+};
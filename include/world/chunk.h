@@ -69,6 +69,12 @@ public:
     static glm::ivec3 globalToLocalPos(const glm::ivec3& globalPos);
     static void globalToLocalPos(const glm::ivec3& globalPos, glm::ivec3& localPosOut, glm::ivec3& chunkPosOut);
 
+    // flat block and light arrays for scans that would otherwise bounds check every block.
+    // Use getIndex to address them
+    const std::array<BlockType, CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE>& getBlockData() const { return m_blocks; }
+    const std::array<uint16_t, CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE>& getLightData() const { return m_lightMap; }
+    static int getIndex(int x, int y, int z) { return x * CHUNK_SIZE * CHUNK_SIZE + z * CHUNK_SIZE + y; }
+
     bool isAllAir() const { return m_allAir; }
     bool isAllSolid() const { return m_allSolid; }
 
@@ -10,6 +10,7 @@
 #include <atomic>
 #include <array>
 #include <vector>
+#include <bit>
 #include "block_data.h"
 #include "chunk.h"
 #include "utils/glm_hash.h"
@@ -27,6 +28,44 @@ struct ChunkLightQueueNode
 class ChunkMap
 {
 public:
+    // Reads blocks through the chunk of the previous read, so reads that stay inside one chunk
+    // index its block array directly instead of looking the chunk up in the map every time.
+    // The chunk is only resolved again when a read crosses into another one. The cursor keeps
+    // that chunk alive, so it sees the blocks as they were when the chunk was resolved
+    class BlockCursor
+    {
+    public:
+        explicit BlockCursor(const ChunkMap& chunkMap) : m_chunkMap(&chunkMap) {}
+
+        BlockType getBlock(const glm::ivec3& pos)
+        {
+            glm::ivec3 chunkPos(pos.x >> CHUNK_SHIFT, pos.y >> CHUNK_SHIFT, pos.z >> CHUNK_SHIFT);
+            if (!m_resolved || chunkPos != m_chunkPos)
+                resolve(chunkPos);
+            if (!m_blocks)
+                return BlockType::Air;
+            const int mask = Chunk::CHUNK_SIZE - 1;
+            return m_blocks[Chunk::getIndex(pos.x & mask, pos.y & mask, pos.z & mask)];
+        }
+
+        // chunk map lookups made so far
+        int getChunkLookups() const { return m_chunkLookups; }
+
+    private:
+        static constexpr int CHUNK_SHIFT = std::countr_zero(static_cast<unsigned int>(Chunk::CHUNK_SIZE));
+        static_assert((1 << CHUNK_SHIFT) == Chunk::CHUNK_SIZE, "BlockCursor needs a power of two chunk size");
+
+        const ChunkMap* m_chunkMap;
+        std::shared_ptr<const Chunk> m_chunk;
+        // nullptr while the chunk is missing or still generating, which reads as air like ChunkMap::getBlock
+        const BlockType* m_blocks = nullptr;
+        glm::ivec3 m_chunkPos{0};
+        bool m_resolved = false;
+        int m_chunkLookups = 0;
+
+        void resolve(const glm::ivec3& chunkPos);
+    };
+
     ChunkMap();
     ~ChunkMap() = default;
 
@@ -67,6 +106,9 @@ public:
 
     std::shared_ptr<const Chunk> getChunk(int x, int y, int z) const;
     std::shared_ptr<const Chunk> getChunk(const glm::ivec3& pos) const;
+    // chunk to write blocks into, cloned first if a snapshot or mesh build still holds it.
+    // nullptr if the chunk is missing or still generating
+    std::shared_ptr<Chunk> getChunkForWrite(const glm::ivec3& pos);
 
     std::vector<std::shared_ptr<const Chunk>> getChunksInRadius(const glm::ivec3& chunkPos, int radius) const;
 private:
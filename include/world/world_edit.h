@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <memory>
+#include <bitset>
+#include <vector>
+#include "block_data.h"
+#include "chunk.h"
+#include "utils/glm_hash.h"
+
+class ChunkMap;
+
+// A box of blocks that can be pasted into the world with WorldEdit::paste
+struct VoxelBuffer
+{
+    glm::ivec3 size{0};
+    // indexed like a chunk, x major then z then y, see getIndex
+    std::vector<BlockType> blocks;
+
+    VoxelBuffer() = default;
+    VoxelBuffer(const glm::ivec3& size, BlockType fill = BlockType::Air)
+        : size(size), blocks(static_cast<size_t>(size.x) * size.y * size.z, fill) {}
+
+    size_t getIndex(int x, int y, int z) const { return (static_cast<size_t>(x) * size.z + z) * size.y + y; }
+    BlockType get(int x, int y, int z) const { return blocks[getIndex(x, y, z)]; }
+    void set(int x, int y, int z, BlockType type) { blocks[getIndex(x, y, z)] = type; }
+};
+
+// Bulk block edits that relight and remesh once for the whole batch instead of once per block.
+//
+// Edits are written into the chunks straight away, each chunk copied on write only the first
+// time the batch touches it. commit relights every edited chunk with one combined set of light
+// nodes and returns the chunks whose meshes need rebuilding, which should be handed to
+// ChunkMapRenderer::queueChunkUpdates. Commit before the next frame is drawn so no mesh is built
+// from blocks that have not been relit yet.
+//
+// Like ChunkMap::setBlock, blocks in chunks that have not finished generating are left alone.
+class WorldEdit
+{
+public:
+    explicit WorldEdit(ChunkMap& chunkMap) : m_chunkMap(&chunkMap) {}
+
+    // min and max are inclusive
+    void fillBox(const glm::ivec3& min, const glm::ivec3& max, BlockType type);
+    // fills every block whose center is within radius of center
+    void fillSphere(const glm::vec3& center, float radius, BlockType type);
+    // replaces the blocks of type from within the inclusive box
+    void replace(const glm::ivec3& min, const glm::ivec3& max, BlockType from, BlockType to);
+    // copies buffer with its first block at origin. With skipAir the air in buffer keeps the world's blocks
+    void paste(const glm::ivec3& origin, const VoxelBuffer& buffer, bool skipAir = false);
+
+    // relights the edited chunks and returns every chunk whose mesh is affected, each once.
+    // The batch is empty again afterwards
+    std::vector<glm::ivec3> commit();
+
+    size_t getChangedBlockCount() const { return m_changedBlocks; }
+    size_t getEditedChunkCount() const { return m_chunkEdits.size(); }
+
+private:
+    static const int CHUNK_VOLUME = Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE;
+
+    struct ChunkEdit
+    {
+        std::shared_ptr<Chunk> chunk;
+        // blocks whose type changed, by Chunk::getIndex
+        std::bitset<CHUNK_VOLUME> changed;
+        // local bounds of the changed blocks, used to tell which neighbors see the edit
+        glm::ivec3 localMin{Chunk::CHUNK_SIZE};
+        glm::ivec3 localMax{-1};
+    };
+
+    ChunkMap* m_chunkMap;
+    std::unordered_map<glm::ivec3, ChunkEdit, glm_ivec3_hash, glm_ivec3_equal> m_chunkEdits;
+    size_t m_changedBlocks = 0;
+
+    // calls blockAt(globalPos, currentType) for every block in the inclusive box, one chunk at a
+    // time, and stores the type it returns
+    template<typename BlockFunc>
+    void edit(const glm::ivec3& min, const glm::ivec3& max, BlockFunc blockAt);
+    // returns nullptr if the chunk is missing or still generating
+    ChunkEdit* getChunkEdit(const glm::ivec3& chunkPos);
+    // collects the light nodes of the changed blocks of one chunk and floods them. Returns false
+    // if the chunk's neighbors are not loaded, in which case its light is left as it was
+    bool relightChunk(const glm::ivec3& chunkPos, const ChunkEdit& chunkEdit);
+};
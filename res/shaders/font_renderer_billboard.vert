@@ -8,10 +8,6 @@ layout (location = 3) in vec2 aTexCoord;
 out vec4 vColor;
 out vec2 vTexCoord;
 
-uniform mat4 uProjection;
-uniform mat4 uView;
-uniform mat4 uModel;
-
 void main(void)
 {
     vColor = aColor;
@@ -22,5 +18,5 @@ void main(void)
     
     vec3 worldPos = aCenter + aPosition.x * cameraRight + aPosition.y * cameraUp;
 
-    gl_Position = uProjection * uView * uModel * vec4(worldPos, 1.0);
+    gl_Position = uViewProj * vec4(worldPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#version 330 core
+
+out vec4 outputColor;
+
+in vec2 vUV;
+in vec4 vColor;
+flat in uint vLevel;
+flat in int vDigitCount;
+
+// digits 0 to 9 side by side, 3x5 texels each, top row first
+uniform sampler2D uDigits;
+
+const int DIGIT_WIDTH = 3;
+const int DIGIT_ROWS = 5;
+
+void main()
+{
+    float cellX = vUV.x * float(vDigitCount);
+    int cell = min(int(cellX), vDigitCount - 1);
+    uint digit = vDigitCount == 2 && cell == 0 ? vLevel / 10u : vLevel % 10u;
+
+    // the last column of every cell is spacing
+    int column = int(fract(cellX) * float(DIGIT_WIDTH + 1));
+    if (column >= DIGIT_WIDTH)
+        discard;
+    int row = min(int((1.0 - vUV.y) * float(DIGIT_ROWS)), DIGIT_ROWS - 1);
+    if (texelFetch(uDigits, ivec2(int(digit) * DIGIT_WIDTH + column, row), 0).r < 0.5)
+        discard;
+
+    outputColor = vColor;
+}
@@ -0,0 +1,36 @@
+#version 330 core
+
+layout(location = 0) in vec3 aCenter;
+layout(location = 1) in uint aLevel;
+
+uniform float uDigitHeight;
+
+out vec2 vUV;
+out vec4 vColor;
+flat out uint vLevel;
+flat out int vDigitCount;
+
+const vec2 QUAD_CORNERS[6] = vec2[](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+    vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0)
+);
+
+void main()
+{
+    vec2 corner = QUAD_CORNERS[gl_VertexID];
+    int digitCount = aLevel >= 10u ? 2 : 1;
+    // a digit is 3 texels wide with one texel of spacing for every 5 texels of height
+    vec2 size = vec2(uDigitHeight * 0.8 * float(digitCount), uDigitHeight);
+    vec2 offset = (corner - 0.5) * size;
+
+    vec3 cameraRight = vec3(uView[0][0], uView[1][0], uView[2][0]);
+    vec3 cameraUp    = vec3(uView[0][1], uView[1][1], uView[2][1]);
+    vec3 worldPos = aCenter + offset.x * cameraRight + offset.y * cameraUp;
+    gl_Position = uViewProj * vec4(worldPos, 1.0);
+
+    float level = float(aLevel) / 15.0;
+    vColor = vec4(1.0 - level, level, 0.2, 1.0);
+    vUV = corner;
+    vLevel = aLevel;
+    vDigitCount = digitCount;
+}
@@ -4,11 +4,7 @@ layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec4 aColor;
 
-uniform mat4 uProjection;
-uniform mat4 uView;
-uniform mat4 uModel;
 uniform float uLineWidth;
-uniform vec2 uResolution;
 
 out vec4 vColor;
 
@@ -23,8 +19,8 @@ const mat4 VIEW_SCALE = mat4(
 void main() {
     vColor = aColor;
 
-    vec4 lineStart = uProjection * VIEW_SCALE * uView * uModel * vec4(aPos, 1.0);
-    vec4 lineEnd = uProjection * VIEW_SCALE * uView * uModel * vec4(aPos + aNormal, 1.0);
+    vec4 lineStart = uProjection * VIEW_SCALE * uView * vec4(aPos, 1.0);
+    vec4 lineEnd = uProjection * VIEW_SCALE * uView * vec4(aPos + aNormal, 1.0);
 
     vec3 ndcStart = lineStart.xyz / lineStart.w;
     vec3 ndcEnd = lineEnd.xyz / lineEnd.w;
@@ -4,9 +4,6 @@ out vec4 outputColor;
 
 in vec2 vTexCoord;
 
-uniform mat4 uInvViewProj;
-uniform float uDayNightFrac;
-
 vec3 nightSkyColorTop = vec3(0.067, 0.067, 0.18);
 vec3 nightSkyColorBottom = vec3(0.1, 0.1, 0.31);
 vec3 daySkyColorTop = vec3(0.5, 0.7, 1.0);
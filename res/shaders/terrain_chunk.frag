@@ -2,16 +2,13 @@
 
 out vec4 outputColor;
 
-in vec2 vTexCoord;
+in vec3 vTexCoord;
 in vec3 vNormal;
 in float vAOValue;
 in float vBlockLightValue;
 in float vSunLightValue;
 
-uniform sampler2D uTexture;
-uniform bool uAOEnabled;
-uniform float uAOIntensity;
-uniform float uDayNightFrac;
+uniform sampler2DArray uTexture;
 
 float diffuse(vec3 normal)
 {
@@ -42,7 +39,7 @@ void main()
     // float diff = max(dot(vNormal, lightDir), 0.0);
     // float ambient = 0.2;
     float ambientOcclusion = 1;
-    if (uAOEnabled)
+    if (uAOEnabled != 0)
         ambientOcclusion =  (1 - uAOIntensity) + ((vAOValue / 3.0) * uAOIntensity);
 
     float sLight = 0.1 + 0.9 * (vSunLightValue * stepPlateau(uDayNightFrac) / 15);
@@ -1,18 +1,22 @@
 #version 330 core
 
-layout(location = 0) in float aData;
-layout(location = 1) in vec2 aTexCoord;
+// x: position, face, AO and light, y: texture index
+layout(location = 0) in uvec2 aData;
 
-out vec2 vTexCoord;
+// xy: uv, z: texture array layer
+out vec3 vTexCoord;
 out vec3 vNormal;
 out float vAOValue;
 out float vBlockLightValue;
 out float vSunLightValue;
 
-uniform mat4 uProjection;
-uniform mat4 uView;
-uniform mat4 uModel;
-uniform vec3 uChunkOffset;
+// texture array layer of every block texture
+uniform int uTextureLayers[64];
+// chunk offset of every page of PAGE_VERTICES vertices in the shared chunk vertex buffer.
+// w holds the level of detail, which is already applied to the vertex positions
+uniform isamplerBuffer uChunkPages;
+
+const int PAGE_VERTICES = 256;
 
 vec3 getNormalFromIndex(int index) {
     switch(int(index))
@@ -34,9 +38,28 @@ vec3 getNormalFromIndex(int index) {
     }
 }
 
+// texture coordinates follow the block grid, so textures repeat across faces larger than a block
+vec2 getFaceUV(vec3 position, uint normalIndex) {
+    switch(int(normalIndex))
+    {
+        case 0: // top
+            return position.xz;
+        case 1: // bottom
+            return vec2(position.x, -position.z);
+        case 2: // front
+            return vec2(position.x, -position.y);
+        case 3: // back
+            return -position.xy;
+        case 4: // left
+            return vec2(position.z, -position.y);
+        default: // right
+            return vec2(-position.z, -position.y);
+    }
+}
+
 void main(void)
 {
-    uint vPacked = floatBitsToUint(aData);
+    uint vPacked = aData.x;
     uint blockLightLevel = vPacked & 0xFu;
     vPacked >>= 4;
     uint sunLightLevel = vPacked & 0xFu;
@@ -57,6 +80,8 @@ void main(void)
     vSunLightValue = float(sunLightLevel);
     vBlockLightValue = float(blockLightLevel);
     vNormal = getNormalFromIndex(int(normalIndex));
-    vTexCoord = aTexCoord;
-    gl_Position = uProjection * uView * uModel * vec4(aPosition + uChunkOffset, 1.0);
+    vTexCoord = vec3(getFaceUV(aPosition, normalIndex), float(uTextureLayers[aData.y]));
+    // gl_VertexID includes the base vertex, so it indexes the shared vertex buffer directly
+    vec3 chunkOffset = vec3(texelFetch(uChunkPages, gl_VertexID / PAGE_VERTICES).xyz);
+    gl_Position = uViewProj * vec4(aPosition + chunkOffset, 1.0);
 }
\ No newline at end of file
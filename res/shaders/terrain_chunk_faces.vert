@@ -0,0 +1,101 @@
+#version 330 core
+
+// Expands one face record per quad into its 4 vertices. Draws use the same quad index buffer
+// and a base vertex of 4 times the face offset, so gl_VertexID / 4 is the face index.
+
+// xy: uv, z: texture array layer
+out vec3 vTexCoord;
+out vec3 vNormal;
+out float vAOValue;
+out float vBlockLightValue;
+out float vSunLightValue;
+
+// texture array layer of every block texture
+uniform int uTextureLayers[64];
+// chunk offset (xyz) and level of detail (w) of every page of PAGE_FACES faces in the shared chunk face buffer
+uniform isamplerBuffer uChunkPages;
+// x: texture index, AO, face and position, y: sun and block light of each corner
+uniform usamplerBuffer uChunkFaces;
+
+const int PAGE_FACES = 256;
+
+// corner offsets of every face, indexed by face * 4 + corner
+const vec3 FACE_CORNERS[24] = vec3[24](
+    // top
+    vec3(0, 1, 1), vec3(1, 1, 1), vec3(1, 1, 0), vec3(0, 1, 0),
+    // bottom
+    vec3(0, 0, 0), vec3(1, 0, 0), vec3(1, 0, 1), vec3(0, 0, 1),
+    // front
+    vec3(0, 0, 1), vec3(1, 0, 1), vec3(1, 1, 1), vec3(0, 1, 1),
+    // back
+    vec3(1, 0, 0), vec3(0, 0, 0), vec3(0, 1, 0), vec3(1, 1, 0),
+    // left
+    vec3(0, 0, 0), vec3(0, 0, 1), vec3(0, 1, 1), vec3(0, 1, 0),
+    // right
+    vec3(1, 0, 1), vec3(1, 0, 0), vec3(1, 1, 0), vec3(1, 1, 1)
+);
+
+const vec3 NORMALS[6] = vec3[6](
+    vec3(0.0, 1.0, 0.0),  // top
+    vec3(0.0, -1.0, 0.0), // bottom
+    vec3(0.0, 0.0, 1.0),  // front
+    vec3(0.0, 0.0, -1.0), // back
+    vec3(-1.0, 0.0, 0.0), // left
+    vec3(1.0, 0.0, 0.0)   // right
+);
+
+// texture coordinates follow the block grid, so textures repeat across faces larger than a block
+vec2 getFaceUV(vec3 position, uint normalIndex) {
+    switch(int(normalIndex))
+    {
+        case 0: // top
+            return position.xz;
+        case 1: // bottom
+            return vec2(position.x, -position.z);
+        case 2: // front
+            return vec2(position.x, -position.y);
+        case 3: // back
+            return -position.xy;
+        case 4: // left
+            return vec2(position.z, -position.y);
+        default: // right
+            return vec2(-position.z, -position.y);
+    }
+}
+
+void main(void)
+{
+    int faceIndex = gl_VertexID >> 2;
+    uvec2 face = texelFetch(uChunkFaces, faceIndex).xy;
+
+    uint fPacked = face.x;
+    uint textureIndex = fPacked & 0x3Fu;
+    fPacked >>= 6u;
+    uvec4 aoValues = uvec4(fPacked, fPacked >> 2u, fPacked >> 4u, fPacked >> 6u) & 0x3u;
+    fPacked >>= 8u;
+    uint normalIndex = fPacked & 0x7u;
+    fPacked >>= 3u;
+    uint posZ = fPacked & 0x1Fu;
+    fPacked >>= 5u;
+    uint posY = fPacked & 0x1Fu;
+    fPacked >>= 5u;
+    uint posX = fPacked & 0x1Fu;
+
+    // the index buffer splits quads along the 0-2 diagonal. Starting from the next corner
+    // splits them along the 1-3 diagonal, which keeps the AO gradient symmetric
+    int flip = (aoValues.x + aoValues.z) < (aoValues.y + aoValues.w) ? 1 : 0;
+    int corner = ((gl_VertexID & 3) + flip) & 3;
+
+    uint light = (face.y >> (8u * uint(corner))) & 0xFFu;
+    vAOValue = float(aoValues[corner]);
+    vSunLightValue = float(light >> 4u);
+    vBlockLightValue = float(light & 0xFu);
+    vNormal = NORMALS[normalIndex];
+
+    // faces of coarser levels store the minimum corner of a cell of 2^lod blocks
+    ivec4 page = texelFetch(uChunkPages, faceIndex / PAGE_FACES);
+    float scale = float(1 << page.w);
+    vec3 aPosition = vec3(float(posX), float(posY), float(posZ)) + FACE_CORNERS[int(normalIndex) * 4 + corner] * scale;
+    vTexCoord = vec3(getFaceUV(aPosition, normalIndex), float(uTextureLayers[textureIndex]));
+    gl_Position = uViewProj * vec4(aPosition + vec3(page.xyz), 1.0);
+}
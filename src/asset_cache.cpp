@@ -0,0 +1,239 @@
+#include "asset_cache.h"
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+#include <spdlog/spdlog.h>
+#include "utils/algorithms.h"
+
+namespace
+{
+    const char CACHE_MAGIC[4] = {'V', 'X', 'A', 'C'};
+    // bounds checked reads over the mapped file. Once a read runs past the end every
+    // following read fails too, so the caller only has to check ok() at the end
+    class CacheReader
+    {
+    public:
+        CacheReader(const unsigned char* data, size_t size) : m_data(data), m_size(size) {}
+
+        template<typename T>
+        T read()
+        {
+            T value{};
+            if (canRead(sizeof(T)))
+                std::memcpy(&value, m_data + m_offset, sizeof(T));
+            m_offset += sizeof(T);
+            return value;
+        }
+
+        // returns a pointer into the file, or nullptr if fewer than size bytes are left
+        const unsigned char* readBytes(size_t size)
+        {
+            const unsigned char* bytes = canRead(size) ? m_data + m_offset : nullptr;
+            m_offset += size;
+            return bytes;
+        }
+
+        std::string readString()
+        {
+            uint32_t length = read<uint32_t>();
+            const unsigned char* bytes = readBytes(length);
+            return bytes ? std::string(reinterpret_cast<const char*>(bytes), length) : std::string();
+        }
+
+        bool ok() const { return !m_failed; }
+
+    private:
+        const unsigned char* m_data;
+        size_t m_size;
+        size_t m_offset = 0;
+        bool m_failed = false;
+
+        bool canRead(size_t size)
+        {
+            if (m_failed || m_offset > m_size || size > m_size - m_offset)
+                m_failed = true;
+            return !m_failed;
+        }
+    };
+
+    template<typename T>
+    void writeValue(std::ofstream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void writeString(std::ofstream& out, const std::string& str)
+    {
+        writeValue(out, static_cast<uint32_t>(str.size()));
+        out.write(str.data(), str.size());
+    }
+}
+
+uint64_t AssetCache::hashSources(const std::vector<std::string>& paths, const std::string& extraKey)
+{
+    uint64_t hash = algo::fnv1a(&VERSION, sizeof(VERSION));
+    hash = algo::fnv1a(extraKey.data(), extraKey.size(), hash);
+    std::vector<char> buffer;
+    for (const auto& path : paths)
+    {
+        hash = algo::fnv1a(path.data(), path.size(), hash);
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            continue;
+        buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(buffer.data(), buffer.size());
+        hash = algo::fnv1a(buffer.data(), buffer.size(), hash);
+    }
+    return hash;
+}
+
+bool AssetCache::open(const std::string& path, uint64_t sourceHash)
+{
+    close();
+    if (!m_file.open(path))
+        return false;
+
+    CacheReader reader(m_file.data(), m_file.size());
+    const unsigned char* magic = reader.readBytes(sizeof(CACHE_MAGIC));
+    uint32_t version = reader.read<uint32_t>();
+    uint64_t hash = reader.read<uint64_t>();
+    uint32_t textureCount = reader.read<uint32_t>();
+    uint32_t fontCount = reader.read<uint32_t>();
+    if (!reader.ok() || std::memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || version != VERSION || hash != sourceHash)
+    {
+        close();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < textureCount && reader.ok(); ++i)
+    {
+        Texture texture;
+        texture.name = reader.readString();
+        texture.width = reader.read<uint32_t>();
+        texture.height = reader.read<uint32_t>();
+        texture.pixels = reader.readBytes(static_cast<size_t>(texture.width) * texture.height * 4);
+        m_textures.push_back(std::move(texture));
+    }
+
+    for (uint32_t i = 0; i < fontCount && reader.ok(); ++i)
+    {
+        Font font;
+        font.path = reader.readString();
+        font.fontSize = reader.read<uint32_t>();
+        uint32_t glyphCount = reader.read<uint32_t>();
+        for (uint32_t j = 0; j < glyphCount && reader.ok(); ++j)
+        {
+            gfx::Glyph glyph;
+            glyph.character = static_cast<wchar_t>(reader.read<uint32_t>());
+            glyph.size.x = reader.read<int32_t>();
+            glyph.size.y = reader.read<int32_t>();
+            glyph.bearing.x = reader.read<int32_t>();
+            glyph.bearing.y = reader.read<int32_t>();
+            glyph.advance = reader.read<uint32_t>();
+            uint32_t bitmapSize = reader.read<uint32_t>();
+            const unsigned char* bitmap = reader.readBytes(bitmapSize);
+            if (bitmapSize == 0)
+            {
+                font.glyphs.push_back(std::move(glyph));
+                continue;
+            }
+            if (!bitmap || glyph.size.x <= 0 || glyph.size.y <= 0 || bitmapSize != static_cast<uint64_t>(glyph.size.x) * glyph.size.y)
+            {
+                spdlog::warn("AssetCache: {} is corrupt and will be rebuilt.", path);
+                close();
+                return false;
+            }
+            glyph.bitmap.assign(bitmap, bitmap + bitmapSize);
+            font.glyphs.push_back(std::move(glyph));
+        }
+        m_fonts.push_back(std::move(font));
+    }
+
+    if (!reader.ok())
+    {
+        spdlog::warn("AssetCache: {} is truncated and will be rebuilt.", path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetCache::close()
+{
+    m_textures.clear();
+    m_fonts.clear();
+    m_file.close();
+}
+
+const AssetCache::Font* AssetCache::getFont(const std::string& path, unsigned int fontSize) const
+{
+    for (const auto& font : m_fonts)
+    {
+        if (font.path == path && font.fontSize == fontSize)
+            return &font;
+    }
+    return nullptr;
+}
+
+bool AssetCache::write(const std::string& path, uint64_t sourceHash, const std::vector<Texture>& textures, const std::vector<Font>& fonts)
+{
+    // written to a temporary file first so a crash mid write never leaves a cache that looks valid
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            spdlog::warn("AssetCache: Failed to open {} for writing.", tempPath);
+            return false;
+        }
+
+        out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        writeValue(out, VERSION);
+        writeValue(out, sourceHash);
+        writeValue(out, static_cast<uint32_t>(textures.size()));
+        writeValue(out, static_cast<uint32_t>(fonts.size()));
+
+        for (const auto& texture : textures)
+        {
+            writeString(out, texture.name);
+            writeValue(out, static_cast<uint32_t>(texture.width));
+            writeValue(out, static_cast<uint32_t>(texture.height));
+            out.write(reinterpret_cast<const char*>(texture.pixels), static_cast<std::streamsize>(texture.width) * texture.height * 4);
+        }
+
+        for (const auto& font : fonts)
+        {
+            writeString(out, font.path);
+            writeValue(out, static_cast<uint32_t>(font.fontSize));
+            writeValue(out, static_cast<uint32_t>(font.glyphs.size()));
+            for (const auto& glyph : font.glyphs)
+            {
+                writeValue(out, static_cast<uint32_t>(glyph.character));
+                writeValue(out, static_cast<int32_t>(glyph.size.x));
+                writeValue(out, static_cast<int32_t>(glyph.size.y));
+                writeValue(out, static_cast<int32_t>(glyph.bearing.x));
+                writeValue(out, static_cast<int32_t>(glyph.bearing.y));
+                writeValue(out, static_cast<uint32_t>(glyph.advance));
+                writeValue(out, static_cast<uint32_t>(glyph.bitmap.size()));
+                out.write(reinterpret_cast<const char*>(glyph.bitmap.data()), glyph.bitmap.size());
+            }
+        }
+
+        if (!out)
+        {
+            spdlog::warn("AssetCache: Failed to write {}.", tempPath);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        spdlog::warn("AssetCache: Failed to replace {}: {}", path, ec.message());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
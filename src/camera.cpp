@@ -63,7 +63,12 @@ void Camera::rotate(float xoffset, float yoffset, bool constrainPitch)
 
 glm::mat4 Camera::getProjectionMatrix() const
 {
-    return glm::perspective(glm::radians(zoom), (float)resolution.x / resolution.y, 0.1f, 5000.0f);
+    return getProjectionMatrix(zoom);
+}
+
+glm::mat4 Camera::getProjectionMatrix(float fovDegrees) const
+{
+    return glm::perspective(glm::radians(fovDegrees), (float)resolution.x / resolution.y, 0.1f, 5000.0f);
 }
 
 glm::mat4 Camera::getViewMatrix() const
@@ -103,6 +108,13 @@ Frustum Camera::getFrustum() const
     return m_frustum;
 }
 
+Frustum Camera::getPaddedFrustum(float fovPadding) const
+{
+    if (freezeFrustum)
+        return m_frustum;
+    return Frustum(getProjectionMatrix(zoom + fovPadding), getViewMatrix());
+}
+
 void Camera::updateCameraVectors()
 {
     glm::vec3 newFront;
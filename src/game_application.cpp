@@ -14,6 +14,7 @@
 
 #include "utils/algorithms.h"
 #include "utils/geometry.h"
+#include "world/world_edit.h"
 
 ResourceManager GameApplication::s_resourceManager;
 
@@ -107,7 +108,10 @@ bool GameApplication::load()
     m_resourceLoader.load({m_fbWidth, m_fbHeight});
     
     m_worldRenderer.loadResources();
-    m_worldRenderer.getChunkMapRenderer().startBuildThread(true);
+    auto screenQuadShader = s_resourceManager.getShader("screen_quad");
+    m_screenQuadResolutionLocation = screenQuadShader->getUniformLocation("uResolution");
+    m_screenQuadCrosshairLocation = screenQuadShader->getUniformLocation("uShowCrosshair");
+    m_worldRenderer.getChunkMapRenderer().startBuildThreads(true, m_worldRenderer.renderOptions.meshBuildThreads);
 
     m_world.getChunkMap().startBuildThread();
 
@@ -121,9 +125,9 @@ void GameApplication::fixedUpdate()
 void GameApplication::unfixedUpdate()
 {
     m_world.update();
-    m_worldRenderer.update();
-    glm::ivec3 camChunkPos = Chunk::globalToChunkPos(m_camera.position);
-    m_worldRenderer.getChunkMapRenderer().queueFrustum(m_camera.getFrustum(), camChunkPos, m_worldRenderer.renderOptions.renderDistance);
+    m_renderDebugPanel.getRenderBenchmark().update(m_camera, m_worldRenderer, static_cast<float>(m_gameTime.deltaTime));
+    m_worldRenderer.update(m_camera);
+    m_worldRenderer.getChunkMapRenderer().updateVisibleSet(m_camera, m_worldRenderer.renderOptions.renderDistance);
 }
 
 void GameApplication::render()
@@ -138,7 +142,7 @@ void GameApplication::render()
     ImGui::Text("Camera Position: (%.2f, %.2f, %.2f)", m_camera.position.x, m_camera.position.y, m_camera.position.z);
     ImGui::SliderFloat("Day/Night Fraction", &m_dayNightFrac, 0.0f, 1.0f);
 
-    auto atlas = s_resourceManager.getTextureAtlas<BlockTexture>("chunk_atlas");
+    auto atlas = s_resourceManager.getTextureAtlas<BlockTexture>("block_icon_atlas");
     for(int i = 1; i < 8; ++i) {
         ImGui::PushID(i);
 
@@ -160,11 +164,23 @@ void GameApplication::render()
 
     if (ImGui::CollapsingHeader("Render Options")) {
         ImGui::Checkbox("Show Chunk Border", &m_worldRenderer.renderOptions.showChunkBorder);
-        ImGui::SliderInt("Render Distance", &m_worldRenderer.renderOptions.renderDistance, 1, 32);
+        ImGui::SliderInt("Render Distance", &m_worldRenderer.renderOptions.renderDistance, 1, 64);
+        ImGui::SliderInt("LOD Distance", &m_worldRenderer.renderOptions.lodDistance, 0, 32);
+        m_renderDebugPanel.draw(m_worldRenderer, m_camera, m_world.getChunkMap(), s_resourceManager);
         if (ImGui::CollapsingHeader("Light Levels")) {
             ImGui::Checkbox("Show Sun Light Levels", &m_worldRenderer.renderOptions.showSunLightLevels);
             ImGui::Checkbox("Show Block Light Levels", &m_worldRenderer.renderOptions.showBlockLightLevels);
-            ImGui::SliderFloat("Radius", &m_worldRenderer.renderOptions.showLightLevelRadius, 1.0f, Chunk::CHUNK_SIZE * 2.0f);
+            ImGui::SliderFloat("Radius", &m_worldRenderer.renderOptions.showLightLevelRadius, 1.0f, Chunk::CHUNK_SIZE * 4.0f);
+            ImGui::Text("Numbers drawn: %zu", m_worldRenderer.getLightLevelRenderer().getInstanceCount());
+        }
+        if (ImGui::CollapsingHeader("World Edit")) {
+            ImGui::SliderFloat("Sphere Radius", &m_editRadius, 1.0f, 32.0f);
+            if (ImGui::Button("Fill Sphere"))
+                editSphere(m_selectedBlockType);
+            ImGui::SameLine();
+            if (ImGui::Button("Clear Sphere"))
+                editSphere(BlockType::Air);
+            ImGui::Text("Last edit: %zu blocks, %zu chunks remeshed, %.3f ms", m_lastEditBlocks, m_lastEditChunks, m_lastEditMs);
         }
         ImGui::Checkbox("Freeze Frustum", &m_camera.freezeFrustum);
         ImGui::Checkbox("Use AO", &m_worldRenderer.renderOptions.useAO);
@@ -179,7 +195,7 @@ void GameApplication::render()
         m_focused = !m_focused;
     }
 
-    if (m_focused) {
+    if (m_focused && !m_renderDebugPanel.getRenderBenchmark().isRunning()) {
         auto mouseDelta = InputManager::getMouseDelta();
         m_camera.rotate(mouseDelta.x, -mouseDelta.y);
         m_window.disableCursor();
@@ -209,24 +225,24 @@ void GameApplication::render()
     renderTarget->use();
     m_window.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    m_worldRenderer.updateFrameData(m_camera, m_dayNightFrac);
+
     m_window.disableDepthTest();
     auto skyShader = s_resourceManager.getShader("sky_color");
     skyShader->use();
-    glm::mat4 viewProj = m_camera.getProjectionMatrix() * m_camera.getViewMatrix();
-    skyShader->setMat4("uInvViewProj", glm::inverse(viewProj));
-    skyShader->setFloat("uDayNightFrac", m_dayNightFrac);
     s_resourceManager.getScreenQuad("sky_quad")->draw();
     m_window.enableDepthTest();
 
     auto mousePos = InputManager::getMousePosition();
     auto lookPos = m_camera.rayDirFromNDC(0, 0);
-    auto node = algo::voxelRayHit(m_camera.position, lookPos, [&](const glm::ivec3& pos) {
-        BlockType block = m_world.getChunkMap().getBlock(pos);
+    ChunkMap::BlockCursor blockCursor(m_world.getChunkMap());
+    auto isTargetable = [&](const glm::ivec3& pos) {
+        BlockType block = blockCursor.getBlock(pos);
         return block != BlockType::Air && block != BlockType::Water;
-    }, 20.0f);
-    BlockType block = m_world.getChunkMap().getBlock(node.pos);
-    if (block != BlockType::Air && block != BlockType::Water) {
-        m_worldRenderer.highlightVoxels({node.pos}, m_camera, m_window);
+    };
+    auto node = algo::voxelRayCast(m_camera.position, lookPos, isTargetable, 20.0f);
+    if (isTargetable(node.pos)) {
+        m_worldRenderer.highlightVoxels({node.pos}, m_window);
         if (InputManager::isMouseButtonJustPressed(MouseButton::Left) && m_focused) {
             m_world.getChunkMap().setBlock(node.pos, BlockType::Air);
             m_worldRenderer.getChunkMapRenderer().queueBlockUpdate(node.pos, BlockType::Air);
@@ -235,7 +251,7 @@ void GameApplication::render()
             m_worldRenderer.getChunkMapRenderer().queueBlockUpdate(node.pos + node.normal, m_selectedBlockType);
         }
     }
-    m_worldRenderer.draw(m_camera, m_window, m_dayNightFrac);
+    m_worldRenderer.draw(m_camera, m_window);
 
     renderTarget->useDefault();
     m_window.clear(GL_COLOR_BUFFER_BIT);
@@ -244,8 +260,8 @@ void GameApplication::render()
     renderTarget->getTexture().use();
     auto screenQuadShader = s_resourceManager.getShader("screen_quad");
     screenQuadShader->use();
-    screenQuadShader->setVec2("uResolution", m_camera.framebufferSize);
-    screenQuadShader->setBool("uShowCrosshair", m_focused);
+    screenQuadShader->setVec2(m_screenQuadResolutionLocation, m_camera.framebufferSize);
+    screenQuadShader->setBool(m_screenQuadCrosshairLocation, m_focused);
     s_resourceManager.getScreenQuad("game_quad")->draw();
 
     imguiEndFrame();
@@ -296,6 +312,18 @@ void GameApplication::imguiEndFrame()
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
+void GameApplication::editSphere(BlockType type)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    WorldEdit worldEdit(m_world.getChunkMap());
+    worldEdit.fillSphere(m_camera.position + m_camera.front * (m_editRadius + 2.0f), m_editRadius, type);
+    m_lastEditBlocks = worldEdit.getChangedBlockCount();
+    auto dirtyChunks = worldEdit.commit();
+    m_worldRenderer.getChunkMapRenderer().queueChunkUpdates(dirtyChunks);
+    m_lastEditChunks = dirtyChunks.size();
+    m_lastEditMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
 void GameApplication::framebufferSizeCallback(GLFWwindow *window, int width, int height)
 {
     GameApplication* app = static_cast<GameApplication*>(glfwGetWindowUserPointer(window));
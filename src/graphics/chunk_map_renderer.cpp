@@ -1,81 +1,294 @@
 #include "graphics/chunk_map_renderer.h"
 #include "utils/algorithms.h"
 
-void ChunkMapRenderer::setupResources(gfx::Shader* chunkShader, gfx::TextureAtlas<BlockTexture>* textureAtlas) 
+void ChunkMapRenderer::setupResources(gfx::Shader* chunkShader, gfx::Shader* chunkFaceShader, gfx::TextureArray<BlockTexture>* blockTextures) 
 {
     m_chunkShader = chunkShader;
-    m_textureAtlas = textureAtlas;
+    m_chunkFaceShader = chunkFaceShader;
+    m_blockTextures = blockTextures;
+    checkPointers();
+    m_meshArena.setup();
+    m_textureLayersShader = nullptr;
+
+    // texture units never change, so the samplers only need to be set once
+    m_chunkShader->setInt("uChunkPages", ChunkMeshArena::PAGE_TABLE_TEXTURE_UNIT);
+    m_chunkFaceShader->setInt("uChunkPages", ChunkMeshArena::PAGE_TABLE_TEXTURE_UNIT);
+    m_chunkFaceShader->setInt("uChunkFaces", ChunkMeshArena::FACE_TEXTURE_UNIT);
+    m_textureLayersLocations = {
+        m_chunkShader->getUniformLocation("uTextureLayers"),
+        m_chunkFaceShader->getUniformLocation("uTextureLayers")
+    };
 }
 
-void ChunkMapRenderer::updateBuildQueue(bool useSmoothLighting) 
+void ChunkMapRenderer::updateBuildQueue(const glm::ivec3& cameraChunkPos, bool useSmoothLighting) 
 {
     checkPointers();
 
-    int meshSubmitCount = 0;
-    while(!m_chunksToSubmit.empty())
+    ChunkReadyNode readyNode;
+    while (m_chunksToSubmit.popNoWait(readyNode))
+        m_pendingUploads.push_back(std::move(readyNode));
+
+    // sorted furthest first so the closest mesh can be popped off the back
+    auto distance2 = [&](const glm::ivec3& chunkPos) {
+        glm::ivec3 d = chunkPos - cameraChunkPos;
+        return d.x * d.x + d.y * d.y + d.z * d.z;
+    };
+    std::sort(m_pendingUploads.begin(), m_pendingUploads.end(), [&](const ChunkReadyNode& a, const ChunkReadyNode& b) {
+        return distance2(a.chunkPos) > distance2(b.chunkPos);
+    });
+
+    auto startTime = std::chrono::steady_clock::now();
+    int uploadCount = 0;
+    size_t uploadedBytes = 0;
+    while (!m_pendingUploads.empty())
     {
-        ChunkReadyNode node;
-        m_chunksToSubmit.pop(node);
-        node.chunkMesh->setup();
-        node.chunkMesh->setDirty(false);
+        ChunkReadyNode& node = m_pendingUploads.back();
+
+        // a newer rebuild of this chunk was queued after this one started, so this mesh
+        // was built from outdated data. Drop it and wait for the newer one instead.
+        auto it = m_chunksInBuildQueue.find(node.chunkPos);
+        if (it == m_chunksInBuildQueue.end() || it->second != node.generation) {
+            m_meshPool.release(std::move(node.chunkMesh));
+            m_pendingUploads.pop_back();
+            --m_buildsInFlight;
+            continue;
+        }
+
+        size_t uploadSize = node.chunkMesh->getUploadSize();
+        if (uploadCount > 0) {
+            float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+            if (uploadedBytes + uploadSize > m_uploadBudgetBytes || elapsedMs >= m_uploadBudgetMs)
+                break;
+        }
+
+        m_chunksInBuildQueue.erase(it);
+        node.chunkMesh->setup(&m_meshArena, node.chunkPos);
+        // meshes next to the camera keep their translucent faces, so the camera can cross into
+        // them without reading the faces back from the arena
+        if (isInTranslucentSortRange(node.chunkPos, cameraChunkPos))
+            node.chunkMesh->retainTranslucentFaces();
+        m_meshPool.releaseBuffers(*node.chunkMesh);
 
+        std::shared_ptr<ChunkMesh> replacedMesh;
+        auto meshIt = m_chunkMeshes.find(node.chunkPos);
+        if (meshIt != m_chunkMeshes.end())
+            replacedMesh = std::move(meshIt->second);
         m_chunkMeshes[node.chunkPos] = node.chunkMesh;
         m_activeChunkMeshes[node.chunkPos] = node.chunkMesh;
-        m_chunksInBuildQueue.erase(node.chunkPos);
-        meshSubmitCount++;
+        m_drawOrderDirty = true;
+        m_meshPool.release(std::move(replacedMesh));
+        m_pendingUploads.pop_back();
+        --m_buildsInFlight;
+        ++uploadCount;
+        uploadedBytes += uploadSize;
     }
 
+    m_meshArena.defragment();
+    // new meshes may open paths through chunks for the visible set search
+    if (uploadCount > 0)
+        m_searchDirty = true;
+
+    m_uploadStats.uploadsLastFrame = uploadCount;
+    m_uploadStats.bytesLastFrame = uploadedBytes;
+    m_uploadStats.queuedMeshes = static_cast<int>(m_pendingUploads.size());
+    m_uploadStats.queuedBytes = 0;
+    for (const auto& node : m_pendingUploads)
+        m_uploadStats.queuedBytes += node.chunkMesh->getUploadSize();
+    if (!m_pendingUploads.empty())
+        ++m_uploadStats.stallFrames;
+}
+
+void ChunkMapRenderer::setUploadBudget(size_t maxBytesPerFrame, float maxMsPerFrame)
+{
+    m_uploadBudgetBytes = maxBytesPerFrame;
+    m_uploadBudgetMs = maxMsPerFrame;
+}
+
+void ChunkMapRenderer::setMeshFormat(ChunkMeshFormat format)
+{
+    if (format == m_meshArena.getFormat())
+        return;
+
+    // meshes free their regions from the arena, so they have to go before it is recreated.
+    // Builds still in flight no longer match a queued generation and are dropped on submit
+    m_activeChunkMeshes.clear();
+    m_drawOrderDirty = true;
+    m_chunkMeshes.clear();
+    m_meshPool.clear();
+    m_chunksInBuildQueue.clear();
+    m_dirtyChunks.clear();
+    m_meshArena.setup(format);
+    m_searchDirty = true;
+}
+
+void ChunkMapRenderer::setCaveCulling(bool useCaveCulling)
+{
+    if (useCaveCulling != m_useCaveCulling)
+        m_searchDirty = true;
+    m_useCaveCulling = useCaveCulling;
+}
+
+void ChunkMapRenderer::setLodDistance(int lodDistance)
+{
+    lodDistance = std::max(0, lodDistance);
+    if (lodDistance != m_lodDistance)
+        m_searchDirty = true;
+    m_lodDistance = lodDistance;
+}
+
+void ChunkMapRenderer::updateVisibleSet(const Camera& camera, int radius)
+{
+    auto now = std::chrono::steady_clock::now();
+    glm::ivec3 cameraChunkPos = Chunk::globalToChunkPos(camera.position);
+    m_lodCenter = cameraChunkPos;
+    static const float ROTATION_THRESHOLD_COS = std::cos(glm::radians(SEARCH_ROTATION_THRESHOLD));
+    bool turned = glm::dot(camera.front, m_searchForward) < ROTATION_THRESHOLD_COS;
+    float sinceSearchMs = std::chrono::duration<float, std::milli>(now - m_searchTime).count();
+
+    bool needsSearch = m_searchDirty
+        || cameraChunkPos != m_searchChunkPos
+        || radius != m_searchRadius
+        || turned
+        || (m_searchIncomplete && sinceSearchMs > SEARCH_RETRY_MS);
+    if (!needsSearch) {
+        ++m_drawStats.framesSinceSearch;
+        return;
+    }
+
+    m_searchChunkPos = cameraChunkPos;
+    m_searchForward = camera.front;
+    m_searchRadius = radius;
+    m_searchDirty = false;
+    m_searchTime = now;
+
+    // the camera can move anywhere within its chunk before the next search, so push the
+    // planes out by the chunk's diagonal on top of the wider field of view
+    Frustum frustum = camera.getPaddedFrustum(SEARCH_FOV_PADDING).padded(Chunk::CHUNK_SIZE * 1.75f);
+    queueFrustum(frustum, cameraChunkPos, radius);
+
+    m_drawStats.searchMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - now).count();
+    m_drawStats.framesSinceSearch = 0;
+}
+
+size_t ChunkMapRenderer::getMeshCPUMemoryUsage() const
+{
+    size_t total = 0;
+    for (const auto& [chunkPos, chunkMesh] : m_chunkMeshes)
+        total += sizeof(ChunkMesh) + chunkMesh->getCPUMemoryUsage();
+    for (const auto& node : m_pendingUploads)
+        total += sizeof(ChunkMesh) + node.chunkMesh->getCPUMemoryUsage();
+    total += m_meshPool.getStats().pooledBytes;
+    return total;
 }
 
 void ChunkMapRenderer::queueFrustum(const Frustum& frustum, const glm::ivec3& chunkPos, int radius) 
 {
-    std::queue<glm::ivec3> nodes;
+    struct SearchNode
+    {
+        glm::ivec3 pos;
+        // face of this chunk the search entered through, -1 for the camera's chunk
+        int entryFace = -1;
+        // bit mask of the directions travelled to reach this chunk
+        uint8_t directions = 0;
+    };
+
+    // with cave culling only chunks reached by the search are drawn, so the active set
+    // is rebuilt every time instead of only growing
+    if (m_useCaveCulling)
+        m_activeChunkMeshes.clear();
+    m_drawOrderDirty = true;
+    m_searchIncomplete = false;
+
+    std::queue<SearchNode> nodes;
     std::unordered_set<glm::ivec3, glm_ivec3_hash, glm_ivec3_equal> visited;
-    nodes.push(chunkPos);
+    nodes.push({chunkPos});
     visited.insert(chunkPos);
     while(!nodes.empty())
     {
-        glm::ivec3 node = nodes.front();
+        SearchNode searchNode = nodes.front();
+        glm::ivec3 node = searchNode.pos;
         nodes.pop();
 
-        if (m_chunkMeshes.contains(node)) {
-            m_activeChunkMeshes[node] = m_chunkMeshes[node];
+        // hidden chunks are still searched through, since chunks behind them may be visible again.
+        // They are activated anyway because draw() tests occlusion every frame, but not built
+        bool occluded = isChunkOccluded(node);
+        ChunkVisibility visibility = ChunkVisibility::allVisible();
+        auto meshIt = m_chunkMeshes.find(node);
+        if (meshIt != m_chunkMeshes.end()) {
+            m_activeChunkMeshes[node] = meshIt->second;
+            visibility = meshIt->second->getVisibility();
+            // the old mesh keeps being drawn until the one at the new level of detail is uploaded
+            if (!m_chunksInBuildQueue.contains(node) && needsLodRebuild(*meshIt->second, node)) {
+                // an occluded chunk can come into view without the camera leaving its chunk,
+                // so the search is retried until it has been rebuilt
+                std::optional<ChunkSnapshot> snapshot;
+                if (!occluded)
+                    snapshot = ChunkSnapshot::CreateSnapshot(*m_chunkMap, node);
+                if (snapshot && m_buildsInFlight < m_maxBuildsInFlight)
+                    queueBuild(snapshot.value(), false);
+                else
+                    m_searchIncomplete = true;
+            }
         } else if (!m_chunksInBuildQueue.contains(node)) {
             std::vector<glm::ivec3> failedChunks;
             auto snapshot = ChunkSnapshot::CreateSnapshot(*m_chunkMap, node, &failedChunks);
             if (snapshot) {
                 glm::vec3 chunkMin = glm::vec3(node) * float(Chunk::CHUNK_SIZE);
                 glm::vec3 chunkMax = chunkMin + glm::vec3(Chunk::CHUNK_SIZE);
-                if (frustum.intersectsAABB(chunkMin, chunkMax) && !snapshot->center()->isAllAir() && m_chunksToBuild.size() < MAX_BUILD_QUEUE_SIZE) {
-                    m_chunksInBuildQueue.insert(node);
-                    m_chunksToBuild.pushBack(snapshot.value());
+                if (frustum.intersectsAABB(chunkMin, chunkMax) && !snapshot->center()->isAllAir()) {
+                    // skipped occluded chunks are retried, since they can come into view while
+                    // the camera stays inside its chunk
+                    if (!occluded && m_buildsInFlight < m_maxBuildsInFlight)
+                        queueBuild(snapshot.value(), false);
+                    else
+                        m_searchIncomplete = true;
                 }
             } else {
+                m_searchIncomplete = true;
                 for (const auto& failedChunk : failedChunks) {
                     m_chunkMap->queueChunk(failedChunk);
                 }
                 continue;
             }
         }
-        
-        for (int dx = -1; dx <= 1; ++dx) {
-            for (int dy = -1; dy <= 1; ++dy) {
-                for (int dz = -1; dz <= 1; ++dz) {
-                    if (dx == 0 && dy == 0 && dz == 0) continue;
-                    glm::ivec3 neighborPos = node + glm::ivec3(dx, dy, dz);
-                    glm::vec3 dOrigin = neighborPos - chunkPos;
-                    float distance2 = dOrigin.x * dOrigin.x + dOrigin.y * dOrigin.y + dOrigin.z * dOrigin.z;
-                    
-                    if (distance2 > radius * radius) continue;
-                    if (visited.contains(neighborPos)) continue;
-                    
-                    glm::vec3 chunkMin = glm::vec3(neighborPos) * float(Chunk::CHUNK_SIZE);
-                    glm::vec3 chunkMax = chunkMin + glm::vec3(Chunk::CHUNK_SIZE);
-                    if (!frustum.intersectsAABB(chunkMin, chunkMax)) continue;
-                    nodes.push(neighborPos);
-                    visited.insert(neighborPos);
+
+        auto tryPush = [&](const glm::ivec3& neighborPos, const SearchNode& next) {
+            glm::vec3 dOrigin = neighborPos - chunkPos;
+            float distance2 = dOrigin.x * dOrigin.x + dOrigin.y * dOrigin.y + dOrigin.z * dOrigin.z;
+            
+            if (distance2 > radius * radius) return;
+            if (visited.contains(neighborPos)) return;
+            
+            glm::vec3 chunkMin = glm::vec3(neighborPos) * float(Chunk::CHUNK_SIZE);
+            glm::vec3 chunkMax = chunkMin + glm::vec3(Chunk::CHUNK_SIZE);
+            if (!frustum.intersectsAABB(chunkMin, chunkMax)) return;
+            nodes.push(next);
+            visited.insert(neighborPos);
+        };
+
+        if (!m_useCaveCulling) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dz = -1; dz <= 1; ++dz) {
+                        if (dx == 0 && dy == 0 && dz == 0) continue;
+                        glm::ivec3 neighborPos = node + glm::ivec3(dx, dy, dz);
+                        tryPush(neighborPos, {neighborPos});
+                    }
                 }
             }
+            continue;
+        }
+
+        // only step through faces the entry face can see, and never back against a direction
+        // already travelled. Chunks that are not meshed yet are treated as fully visible
+        for (int i = 0; i < ChunkVisibility::FACE_COUNT; ++i) {
+            BlockFace exitFace = static_cast<BlockFace>(i);
+            BlockFace backFace = ChunkVisibility::opposite(exitFace);
+            if (searchNode.directions & (1 << static_cast<int>(backFace))) continue;
+            if (searchNode.entryFace >= 0 && !visibility.canSeeThrough(static_cast<BlockFace>(searchNode.entryFace), exitFace)) continue;
+
+            glm::ivec3 neighborPos = node + glm::ivec3(DirectionUtils::blockfaceDirection(exitFace));
+            tryPush(neighborPos, {neighborPos, static_cast<int>(backFace), static_cast<uint8_t>(searchNode.directions | (1 << i))});
         }
     }
 }
@@ -87,6 +300,7 @@ void ChunkMapRenderer::queueChunkRadius(const glm::ivec3& chunkPos, int radius)
     {
         if (m_chunkMeshes.contains(pos)) {
             m_activeChunkMeshes[pos] = m_chunkMeshes[pos];
+            m_drawOrderDirty = true;
             continue;
         }
         if (m_chunksInBuildQueue.contains(pos))
@@ -95,8 +309,7 @@ void ChunkMapRenderer::queueChunkRadius(const glm::ivec3& chunkPos, int radius)
         auto snapshot = ChunkSnapshot::CreateSnapshot(*m_chunkMap, pos);
         if (!snapshot)
             continue;
-        m_chunksInBuildQueue.insert(pos);
-        m_chunksToBuild.pushBack(snapshot.value());
+        queueBuild(snapshot.value(), false);
     }
 }
 
@@ -150,82 +363,178 @@ void ChunkMapRenderer::queueBlockUpdate(const glm::ivec3& blockPos, BlockType bl
     setDirty(chunkPos);
 }
 
-void ChunkMapRenderer::draw(const Camera& camera, int viewDistance, bool useAO, float aoFactor, float dayNightFrac)
+void ChunkMapRenderer::queueChunkUpdates(const std::vector<glm::ivec3>& chunkPositions)
+{
+    for (const auto& chunkPos : chunkPositions)
+        setDirty(chunkPos);
+    // an edit can open or close paths the cave culling search walks through
+    if (!chunkPositions.empty())
+        m_searchDirty = true;
+}
+
+void ChunkMapRenderer::updateOcclusion(const Camera& camera)
+{
+    m_drawStats.occluders = 0;
+    if (!m_useOcclusionCulling)
+        return;
+
+    auto startTime = std::chrono::steady_clock::now();
+    glm::ivec3 cameraChunkPos = Chunk::globalToChunkPos(camera.position);
+    Frustum frustum = camera.getFrustum();
+    m_occlusionBuffer.clear(camera.getProjectionMatrix() * camera.getViewMatrix(), camera.position);
+
+    m_occluderCandidates.clear();
+    for (const auto& [chunkPos, chunkMesh] : m_chunkMeshes)
+    {
+        if (!chunkMesh->getVisibility().isOpaque())
+            continue;
+        glm::ivec3 delta = chunkPos - cameraChunkPos;
+        float distance2 = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
+        if (distance2 > OCCLUDER_RADIUS * OCCLUDER_RADIUS)
+            continue;
+        glm::vec3 chunkMin = glm::vec3(chunkPos) * float(Chunk::CHUNK_SIZE);
+        if (!frustum.intersectsAABB(chunkMin, chunkMin + glm::vec3(Chunk::CHUNK_SIZE)))
+            continue;
+        m_occluderCandidates.push_back({distance2, chunkPos});
+    }
+
+    // closer occluders cover more of the screen
+    size_t occluderCount = std::min<size_t>(m_occluderCandidates.size(), MAX_OCCLUDERS);
+    std::partial_sort(m_occluderCandidates.begin(), m_occluderCandidates.begin() + occluderCount, m_occluderCandidates.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t i = 0; i < occluderCount; ++i)
+    {
+        glm::vec3 chunkMin = glm::vec3(m_occluderCandidates[i].second) * float(Chunk::CHUNK_SIZE);
+        m_occlusionBuffer.addOccluder(chunkMin, chunkMin + glm::vec3(Chunk::CHUNK_SIZE));
+    }
+
+    m_drawStats.occluders = static_cast<int>(occluderCount);
+    m_drawStats.occlusionMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void ChunkMapRenderer::draw(const Camera& camera, int viewDistance)
 {
     checkPointers();
 
+    auto cullStart = std::chrono::steady_clock::now();
     glm::ivec3 cameraChunkPos = Chunk::globalToChunkPos(camera.position);
     Frustum frustum = camera.getFrustum();
-    std::queue<glm::ivec3> chunksToUnLoad;
-    for (auto& [chunkPos, chunkMesh] : m_activeChunkMeshes)
+    std::vector<glm::ivec3> chunksToUnLoad;
+    updateDrawOrder(cameraChunkPos);
+    updateTranslucentSort(camera);
+    m_cullCandidates.clear();
+    m_cullBounds.clear();
+    for (const auto& [distance2, chunkPos, chunkMesh] : m_drawOrder)
     {
-        if (chunkMesh->isDirty() && !m_chunksInBuildQueue.contains(chunkPos)) {
+        // dirty chunks are rebuilt even if an older build is still in flight.
+        // The older build will be discarded when it is submitted.
+        if (m_dirtyChunks.contains(chunkPos)) {
             auto snapshot = ChunkSnapshot::CreateSnapshot(*m_chunkMap, chunkPos);
             if (snapshot) {
-                m_chunksToBuild.pushFront(snapshot.value());
-                m_chunksInBuildQueue.insert(chunkPos);
+                queueBuild(snapshot.value(), true);
+                m_dirtyChunks.erase(chunkPos);
             }
         }
 
-        glm::ivec3 delta = chunkPos - cameraChunkPos;
-        float distance2 = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
-        if (distance2 > viewDistance * viewDistance) {
-            chunksToUnLoad.push(chunkPos);
+        if (distance2 > static_cast<uint32_t>(viewDistance * viewDistance)) {
+            chunksToUnLoad.push_back(chunkPos);
             continue;
         }
         glm::vec3 chunkMin = glm::vec3(chunkPos) * float(Chunk::CHUNK_SIZE);
-        glm::vec3 chunkMax = chunkMin + glm::vec3(Chunk::CHUNK_SIZE);
-        if (!frustum.intersectsAABB(chunkMin, chunkMax)) {
-            chunksToUnLoad.push(chunkPos);
+        m_cullBounds.push(chunkMin, chunkMin + glm::vec3(Chunk::CHUNK_SIZE));
+        m_cullCandidates.push_back({chunkPos, chunkMesh});
+    }
+
+    // frustum test every candidate in one batch, then walk the sorted visible indices.
+    // Chunks outside the frustum stay active, since the visible set is only searched again
+    // once the camera has turned or moved far enough
+    frustum.intersectsAABBs(m_cullBounds, m_visibleIndices);
+    m_drawList.clear();
+    m_drawStats.occludedChunks = 0;
+    m_drawStats.lodChunks.fill(0);
+    size_t nextVisible = 0;
+    for (size_t i = 0; i < m_cullCandidates.size(); ++i)
+    {
+        const auto& [chunkPos, chunkMesh] = m_cullCandidates[i];
+        if (nextVisible >= m_visibleIndices.size() || m_visibleIndices[nextVisible] != i)
+            continue;
+        ++nextVisible;
+        if (isChunkOccluded(chunkPos)) {
+            ++m_drawStats.occludedChunks;
             continue;
         }
+        m_drawList.push_back(chunkMesh);
+        ++m_drawStats.lodChunks[chunkMesh->getLod()];
     }
-    while (!chunksToUnLoad.empty())
-    {
-        glm::ivec3 chunkPos = chunksToUnLoad.front();
-        chunksToUnLoad.pop();
+    for (const auto& chunkPos : chunksToUnLoad)
         m_activeChunkMeshes.erase(chunkPos);
-    }
-
-    m_textureAtlas->use();
-    m_chunkShader->use();
-    m_chunkShader->setMat4("uProjection", camera.getProjectionMatrix());
-    m_chunkShader->setMat4("uView", camera.getViewMatrix());
-    m_chunkShader->setMat4("uModel", glm::mat4(1.0f));
-    m_chunkShader->setBool("uAOEnabled", useAO);
-    m_chunkShader->setFloat("uAOIntensity", aoFactor);
-    m_chunkShader->setFloat("uDayNightFrac", dayNightFrac);
+    if (!chunksToUnLoad.empty())
+        m_drawOrderDirty = true;
+    m_drawStats.cullMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
 
-    for (auto& [chunkPos, chunkMesh] : m_activeChunkMeshes)
+    bool useFaces = m_meshArena.getFormat() == ChunkMeshFormat::Faces;
+    gfx::Shader* shader = useFaces ? m_chunkFaceShader : m_chunkShader;
+    m_blockTextures->use();
+    shader->use();
+    // the table only changes when textures are added to the array, and uniforms are kept per
+    // program, so it is uploaded again only after a change or a switch to the other shader
+    if (updateTextureLayers() || shader != m_textureLayersShader)
     {
-        m_chunkShader->setVec3("uChunkOffset", glm::vec3(chunkPos) * float(Chunk::CHUNK_SIZE));
-        chunkMesh->draw(RenderLayer::Opaque);
+        shader->setIntArray(m_textureLayersLocations[useFaces], m_textureLayers.data(), ChunkMesh::MAX_BLOCK_TEXTURES);
+        m_textureLayersShader = shader;
     }
 
-    for (auto& [chunkPos, chunkMesh] : m_activeChunkMeshes)
-    {
-        m_chunkShader->setVec3("uChunkOffset", glm::vec3(chunkPos) * float(Chunk::CHUNK_SIZE));
-        chunkMesh->draw(RenderLayer::Translucent);
-    }
+    auto submitStart = std::chrono::steady_clock::now();
+    m_meshArena.bind();
+    m_drawStats.drawnChunks = 0;
+    m_drawStats.drawCalls = 0;
+    // multi-draw commands are executed in order, so the batches keep the draw list order
+    auto addToBatch = [&](ChunkMesh* chunkMesh, RenderLayer layer) {
+        const auto& region = chunkMesh->getRegion(layer);
+        if (!region.isValid())
+            return;
+        m_meshArena.addToBatch(region);
+        ++m_drawStats.drawnChunks;
+    };
+    m_meshArena.clearBatch();
+    for (auto it = m_drawList.begin(); it != m_drawList.end(); ++it)
+        addToBatch(*it, RenderLayer::Opaque);
+    m_drawStats.drawCalls += m_meshArena.drawBatch();
+    m_meshArena.clearBatch();
+    for (auto it = m_drawList.rbegin(); it != m_drawList.rend(); ++it)
+        addToBatch(*it, RenderLayer::Translucent);
+    m_drawStats.drawCalls += m_meshArena.drawBatch();
+    glBindVertexArray(0);
+    m_drawStats.submitMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
 }
 
-void ChunkMapRenderer::meshBuildThreadFunc(const gfx::TextureAtlas<BlockTexture>& atlas, bool useSmoothLighting) {
+void ChunkMapRenderer::meshBuildThreadFunc(bool useSmoothLighting) {
     while (!m_stopThread)
     {
-        ChunkSnapshot snapshot;
-        if (!m_chunksToBuild.popFrontNoWait(snapshot)) {
+        ChunkBuildNode node;
+        if (!m_chunksToBuild.popFrontNoWait(node)) {
             std::this_thread::sleep_for(std::chrono::milliseconds(1));
             continue;
         }
-        auto chunkMesh = std::make_shared<ChunkMesh>();
-        chunkMesh->buildMesh(snapshot, atlas, useSmoothLighting);
-        m_chunksToSubmit.push({snapshot.center()->getPos(), chunkMesh});
+        // pooled meshes come with buffers sized by earlier builds, so most builds never reallocate
+        auto chunkMesh = m_meshPool.acquire();
+        size_t prevCapacity = chunkMesh->getCPUMemoryUsage();
+        chunkMesh->buildMesh(node.snapshot, useSmoothLighting, node.format, node.lod);
+        m_meshPool.recordBuild(chunkMesh->getCPUMemoryUsage() > prevCapacity);
+        m_chunksToSubmit.push({node.snapshot.center()->getPos(), chunkMesh, node.generation});
     }
 }
 
-void ChunkMapRenderer::startBuildThread(bool useSmoothLighting) {
+void ChunkMapRenderer::startBuildThreads(bool useSmoothLighting, int threadCount) {
+    if (threadCount <= 0) {
+        // leave room for the main thread and the chunk generation/light threads
+        int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+        threadCount = std::max(1, hardwareThreads - 3);
+    }
     m_stopThread = false;
-    std::thread([this, useSmoothLighting]() { meshBuildThreadFunc(*m_textureAtlas, useSmoothLighting); }).detach();
+    m_buildThreadCount = threadCount;
+    for (int i = 0; i < threadCount; ++i)
+        std::thread([this, useSmoothLighting]() { meshBuildThreadFunc(useSmoothLighting); }).detach();
 }
 
 bool ChunkMapRenderer::checkNeighborChunks(const glm::ivec3& chunkPos, bool checkSelf) const
@@ -247,18 +556,143 @@ bool ChunkMapRenderer::checkNeighborChunks(const glm::ivec3& chunkPos, bool chec
     return true;
 }
 
+void ChunkMapRenderer::updateDrawOrder(const glm::ivec3& cameraChunkPos)
+{
+    if (!m_drawOrderDirty && cameraChunkPos == m_drawOrderChunkPos)
+        return;
+    m_drawOrderDirty = false;
+    m_drawOrderChunkPos = cameraChunkPos;
+
+    m_drawOrder.clear();
+    for (const auto& [chunkPos, chunkMesh] : m_activeChunkMeshes)
+    {
+        glm::ivec3 d = chunkPos - cameraChunkPos;
+        uint32_t distance2 = static_cast<uint32_t>(d.x * d.x + d.y * d.y + d.z * d.z);
+        m_drawOrder.push_back({distance2, chunkPos, chunkMesh.get()});
+    }
+    // distances in chunks are small, so this is usually a two pass sort
+    algo::radixSort(m_drawOrder, m_drawOrderScratch, [](const DrawOrderEntry& entry) { return entry.distance2; });
+}
+
+void ChunkMapRenderer::updateTranslucentSort(const Camera& camera)
+{
+    glm::ivec3 cameraChunkPos = Chunk::globalToChunkPos(camera.position);
+    if (cameraChunkPos != m_translucentSortChunkPos) {
+        // drop the faces of the meshes the camera moved away from
+        const int range = TRANSLUCENT_KEEP_RANGE;
+        for (int x = -range; x <= range; ++x)
+        {
+            for (int y = -range; y <= range; ++y)
+            {
+                for (int z = -range; z <= range; ++z)
+                {
+                    glm::ivec3 chunkPos = m_translucentSortChunkPos + glm::ivec3(x, y, z);
+                    if (isInTranslucentSortRange(chunkPos, cameraChunkPos))
+                        continue;
+                    auto prevIt = m_chunkMeshes.find(chunkPos);
+                    if (prevIt != m_chunkMeshes.end())
+                        prevIt->second->releaseTranslucentFaces();
+                }
+            }
+        }
+        m_translucentSortChunkPos = cameraChunkPos;
+    }
+
+    auto it = m_chunkMeshes.find(cameraChunkPos);
+    if (it == m_chunkMeshes.end() || !it->second->getRegion(RenderLayer::Translucent).isValid())
+        return;
+    ChunkMesh& chunkMesh = *it->second;
+    // a mesh uploaded while the camera was further away has only its arena copy of the faces.
+    // Reading them back is far cheaper than rebuilding the mesh, which is only the fallback
+    if (!chunkMesh.hasTranslucentFaces() && !chunkMesh.restoreTranslucentFaces()) {
+        if (!m_chunksInBuildQueue.contains(cameraChunkPos))
+            setDirty(cameraChunkPos);
+        return;
+    }
+
+    glm::vec3 viewPos = camera.position - glm::vec3(cameraChunkPos * Chunk::CHUNK_SIZE);
+    const auto& sortPos = chunkMesh.getTranslucentSortPos();
+    if (sortPos) {
+        glm::vec3 moved = viewPos - *sortPos;
+        if (glm::dot(moved, moved) < TRANSLUCENT_SORT_DISTANCE * TRANSLUCENT_SORT_DISTANCE)
+            return;
+    }
+    chunkMesh.sortTranslucentFaces(viewPos, m_translucentSortScratch);
+}
+
+bool ChunkMapRenderer::isChunkOccluded(const glm::ivec3& chunkPos) const
+{
+    if (!m_useOcclusionCulling)
+        return false;
+    glm::vec3 chunkMin = glm::vec3(chunkPos) * float(Chunk::CHUNK_SIZE);
+    return !m_occlusionBuffer.isVisible(chunkMin, chunkMin + glm::vec3(Chunk::CHUNK_SIZE));
+}
+
+bool ChunkMapRenderer::updateTextureLayers()
+{
+    bool changed = false;
+    for (int i = 0; i < ChunkMesh::MAX_BLOCK_TEXTURES; ++i)
+    {
+        int layer = std::max(0, m_blockTextures->getLayer(static_cast<BlockTexture>(i)));
+        changed |= layer != m_textureLayers[i];
+        m_textureLayers[i] = layer;
+    }
+    return changed;
+}
+
 void ChunkMapRenderer::checkPointers() const
 {
     if (!m_chunkShader)
         throw std::runtime_error("ChunkMapRenderer: Shader pointer is null.");
-    if (!m_textureAtlas)
-        throw std::runtime_error("ChunkMapRenderer: TextureAtlas pointer is null.");
+    if (!m_chunkFaceShader)
+        throw std::runtime_error("ChunkMapRenderer: Face shader pointer is null.");
+    if (!m_blockTextures)
+        throw std::runtime_error("ChunkMapRenderer: Block texture array pointer is null.");
+}
+
+bool ChunkMapRenderer::isInTranslucentSortRange(const glm::ivec3& chunkPos, const glm::ivec3& cameraChunkPos)
+{
+    glm::ivec3 d = glm::abs(chunkPos - cameraChunkPos);
+    return std::max({d.x, d.y, d.z}) <= TRANSLUCENT_KEEP_RANGE;
 }
 
 inline void ChunkMapRenderer::setDirty(const glm::ivec3& chunkPos)
 {
-    auto it = m_chunkMeshes.find(chunkPos);
-    if (it != m_chunkMeshes.end()) {
-        it->second->setDirty(true);
-    }
+    if (m_chunkMeshes.contains(chunkPos) || m_chunksInBuildQueue.contains(chunkPos))
+        m_dirtyChunks.insert(chunkPos);
+    else
+        // the visible set search skipped it, most likely because it was all air. Searching
+        // again queues it if it is in view and has blocks now
+        m_searchDirty = true;
+}
+
+void ChunkMapRenderer::queueBuild(const ChunkSnapshot& snapshot, bool prioritize)
+{
+    glm::ivec3 chunkPos = snapshot.center()->getPos();
+    uint32_t generation = m_nextBuildGeneration++;
+    m_chunksInBuildQueue[chunkPos] = generation;
+    ++m_buildsInFlight;
+    ChunkBuildNode node{snapshot, generation, m_meshArena.getFormat(), getLodLevel(chunkPos)};
+    if (prioritize)
+        m_chunksToBuild.pushFront(std::move(node));
+    else
+        m_chunksToBuild.pushBack(std::move(node));
+}
+
+int ChunkMapRenderer::getLodLevel(const glm::ivec3& chunkPos, float bias) const
+{
+    if (m_lodDistance <= 0)
+        return 0;
+    glm::vec3 d = chunkPos - m_lodCenter;
+    float distance = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z) - bias;
+    return std::clamp(static_cast<int>(distance / m_lodDistance), 0, ChunkMesh::MAX_LOD);
+}
+
+bool ChunkMapRenderer::needsLodRebuild(const ChunkMesh& chunkMesh, const glm::ivec3& chunkPos) const
+{
+    // meshes are refined as soon as they are too coarse, but only coarsened once they are a
+    // chunk past the threshold, so moving back and forth across it does not rebuild them each time
+    if (getLodLevel(chunkPos) < chunkMesh.getLod())
+        return true;
+    return getLodLevel(chunkPos, 1.0f) > chunkMesh.getLod();
 }
\ No newline at end of file
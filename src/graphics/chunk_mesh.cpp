@@ -1,34 +1,191 @@
 #include "graphics/chunk_mesh.h"
 #include "game_application.h"
+#include "utils/algorithms.h"
+#include <bit>
 
-void ChunkMesh::setup()
+void ChunkMeshBuffers::clear()
 {
-    if (m_indexCounter != 0)
-        m_mesh.populate(m_vertices, m_indices, {1, 2});
-    if (m_indexCounterTranslucent != 0)
-        m_meshTranslucent.populate(m_verticesTranslucent, m_indicesTranslucent, {1, 2});
-    if (m_indexCounterTransparent != 0)
-        m_meshTransparent.populate(m_verticesTransparent, m_indicesTransparent, {1, 2});
+    for (auto& layer : layers)
+        layer.clear();
 }
 
-void ChunkMesh::draw(RenderLayer layer)
+size_t ChunkMeshBuffers::getSizeBytes() const
+{
+    size_t size = 0;
+    for (const auto& layer : layers)
+        size += layer.size();
+    return size * sizeof(uint32_t);
+}
+
+size_t ChunkMeshBuffers::getCapacityBytes() const
+{
+    size_t capacity = 0;
+    for (const auto& layer : layers)
+        capacity += layer.capacity();
+    return capacity * sizeof(uint32_t);
+}
+
+ChunkMesh::~ChunkMesh()
+{
+    releaseRegions();
+}
+
+ChunkMesh::ChunkMesh(ChunkMesh&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+ChunkMesh& ChunkMesh::operator=(ChunkMesh&& other) noexcept
+{
+    if (this != &other)
+    {
+        releaseRegions();
+        m_arena = other.m_arena;
+        m_chunkPos = other.m_chunkPos;
+        m_format = other.m_format;
+        m_lod = other.m_lod;
+        m_visibility = other.m_visibility;
+        m_region = other.m_region;
+        m_regionTranslucent = other.m_regionTranslucent;
+        m_regionTransparent = other.m_regionTransparent;
+        m_buffers = std::move(other.m_buffers);
+        m_translucentFaces = std::move(other.m_translucentFaces);
+        m_translucentSortPos = other.m_translucentSortPos;
+
+        other.m_arena = nullptr;
+        other.m_region = ChunkMeshArena::Region();
+        other.m_regionTranslucent = ChunkMeshArena::Region();
+        other.m_regionTransparent = ChunkMeshArena::Region();
+    }
+    return *this;
+}
+
+void ChunkMesh::setup(ChunkMeshArena* arena, const glm::ivec3& chunkPos)
+{
+    releaseRegions();
+    m_arena = arena;
+    m_chunkPos = chunkPos;
+    m_region = m_arena->allocate(chunkPos, m_buffers.layers[static_cast<int>(RenderLayer::Opaque)], m_lod);
+    m_regionTranslucent = m_arena->allocate(chunkPos, m_buffers.layers[static_cast<int>(RenderLayer::Translucent)], m_lod);
+    m_regionTransparent = m_arena->allocate(chunkPos, m_buffers.layers[static_cast<int>(RenderLayer::Transparent)], m_lod);
+    m_translucentFaces.clear();
+    m_translucentSortPos.reset();
+}
+
+void ChunkMesh::releaseRegions()
+{
+    if (!m_arena)
+        return;
+    m_arena->free(m_region);
+    m_arena->free(m_regionTranslucent);
+    m_arena->free(m_regionTransparent);
+    m_arena = nullptr;
+}
+
+ChunkMeshBuffers ChunkMesh::takeBuffers()
+{
+    ChunkMeshBuffers buffers = std::move(m_buffers);
+    m_buffers = ChunkMeshBuffers();
+    return buffers;
+}
+
+void ChunkMesh::setBuffers(ChunkMeshBuffers&& buffers)
+{
+    m_buffers = std::move(buffers);
+}
+
+void ChunkMesh::retainTranslucentFaces()
+{
+    m_translucentFaces = m_buffers.layers[static_cast<int>(RenderLayer::Translucent)];
+    m_translucentSortPos.reset();
+}
+
+bool ChunkMesh::restoreTranslucentFaces()
+{
+    if (!m_arena || !m_regionTranslucent.isValid())
+        return false;
+    m_arena->read(m_regionTranslucent, m_translucentFaces);
+    m_translucentSortPos.reset();
+    return true;
+}
+
+void ChunkMesh::releaseTranslucentFaces()
+{
+    m_translucentFaces = std::vector<uint32_t>();
+    m_translucentSortPos.reset();
+}
+
+void ChunkMesh::sortTranslucentFaces(const glm::vec3& viewPos, TranslucentSortScratch& scratch)
+{
+    if (!m_arena || !m_regionTranslucent.isValid() || m_translucentFaces.empty())
+        return;
+
+    static const glm::vec3 FACE_NORMALS[6] = {
+        {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}
+    };
+    auto& keys = scratch.keys;
+    auto& sortedFaces = scratch.sortedFaces;
+
+    bool faceFormat = m_format == ChunkMeshFormat::Faces;
+    size_t faceWords = faceFormat ? ChunkMeshArena::WORDS_PER_ELEMENT : ChunkMeshArena::WORDS_PER_ELEMENT * ChunkMeshArena::VERTICES_PER_QUAD;
+    size_t faceCount = m_translucentFaces.size() / faceWords;
+    keys.resize(faceCount);
+    for (size_t i = 0; i < faceCount; ++i)
+    {
+        const uint32_t* face = &m_translucentFaces[i * faceWords];
+        glm::vec3 center;
+        if (faceFormat)
+        {
+            // see addFace for the bit layout
+            glm::vec3 blockPos((face[0] >> 27) & 31, (face[0] >> 22) & 31, (face[0] >> 17) & 31);
+            center = blockPos + 0.5f + 0.5f * FACE_NORMALS[(face[0] >> 14) & 7];
+        }
+        else
+        {
+            center = glm::vec3(0.0f);
+            for (size_t v = 0; v < ChunkMeshArena::VERTICES_PER_QUAD; ++v)
+            {
+                uint32_t packed = face[v * ChunkMeshArena::WORDS_PER_ELEMENT];
+                center += glm::vec3((packed >> 25) & 63, (packed >> 19) & 63, (packed >> 13) & 63);
+            }
+            center *= 0.25f;
+        }
+        // the bits of a positive float sort in the same order as its value,
+        // so inverting them sorts the furthest face first
+        glm::vec3 d = center - viewPos;
+        float distance2 = d.x * d.x + d.y * d.y + d.z * d.z;
+        keys[i] = {~std::bit_cast<uint32_t>(distance2), static_cast<uint32_t>(i)};
+    }
+    algo::radixSort(keys, scratch.keyScratch, [](const TranslucentSortScratch::FaceKey& k) { return k.key; });
+
+    sortedFaces.resize(m_translucentFaces.size());
+    for (size_t i = 0; i < faceCount; ++i)
+        std::copy_n(&m_translucentFaces[keys[i].face * faceWords], faceWords, &sortedFaces[i * faceWords]);
+    m_translucentFaces.swap(sortedFaces);
+    m_arena->update(m_regionTranslucent, m_translucentFaces);
+    m_translucentSortPos = viewPos;
+}
+
+size_t ChunkMesh::getUploadSize() const
+{
+    return m_buffers.getSizeBytes();
+}
+
+size_t ChunkMesh::getCPUMemoryUsage() const
+{
+    return m_buffers.getCapacityBytes() + m_translucentFaces.capacity() * sizeof(uint32_t);
+}
+
+const ChunkMeshArena::Region& ChunkMesh::getRegion(RenderLayer layer) const
 {
     switch (layer)
     {
-        case RenderLayer::Opaque:
-            if (m_indexCounter != 0)
-                m_mesh.draw();
-            break;
         case RenderLayer::Translucent:
-            if (m_indexCounterTranslucent != 0)
-                m_meshTranslucent.draw();
-            break;
+            return m_regionTranslucent;
         case RenderLayer::Transparent:
-            if (m_indexCounterTransparent != 0)
-                m_meshTransparent.draw();
-            break;
+            return m_regionTransparent;
         default:
-            return; // Invalid layer
+            return m_region;
     }
 }
 
@@ -40,26 +197,31 @@ bool inBounds(const glm::ivec3& pos) {
 
 void ChunkMesh::clearMesh()
 {
-    m_vertices.clear();
-    m_indices.clear();
-    m_indexCounter = 0;
-
-    m_verticesTranslucent.clear();
-    m_indicesTranslucent.clear();
-    m_indexCounterTranslucent = 0;
+    m_buffers.clear();
+}
 
-    m_verticesTransparent.clear();
-    m_indicesTransparent.clear();
-    m_indexCounterTransparent = 0;
+void ChunkMesh::releaseCPUData()
+{
+    // replace with empty vectors since clear() keeps the capacity
+    m_buffers = ChunkMeshBuffers();
 }
 
-void ChunkMesh::buildMesh(const ChunkSnapshot& snapshot, const gfx::TextureAtlas<BlockTexture>& atlas, bool smoothLighting)
+void ChunkMesh::buildMesh(const ChunkSnapshot& snapshot, bool smoothLighting, ChunkMeshFormat format, int lod)
 {
+    m_visibility = ChunkVisibility::allVisible();
+    m_lod = std::clamp(lod, 0, MAX_LOD);
     if (!snapshot.isValid())
         return;
     if (snapshot.center()->isAllAir())
         return;
     clearMesh();
+    m_format = format;
+    m_visibility.compute(*snapshot.center());
+    if (m_lod > 0)
+    {
+        buildLodMesh(snapshot);
+        return;
+    }
     for (int x = 0; x < Chunk::CHUNK_SIZE; ++x)
     {
         for (int z = 0; z < Chunk::CHUNK_SIZE; ++z)
@@ -71,40 +233,12 @@ void ChunkMesh::buildMesh(const ChunkSnapshot& snapshot, const gfx::TextureAtlas
                 if (blockType == BlockType::Air)
                     continue;
                 
-                BlockTexture blockTexture;
                 BlockTextureData blockTextureData = BlockData::getBlockTextureData(blockType);
-                std::array<float, 8> textureCoords;
-                bool texureFaceAllSame = blockTextureData.allSame();
-                if (texureFaceAllSame) {
-                    blockTexture = blockTextureData.getTexture(BlockFace::Top);
-                    auto [uvMin, uvMax] = atlas.get(blockTexture);
-
-                    textureCoords = 
-                    {
-                        uvMin.x, uvMax.y,
-                        uvMax.x, uvMax.y,
-                        uvMax.x, uvMin.y,
-                        uvMin.x, uvMin.y
-                    };
-                }
 
                 RenderLayer layer = getRenderLayer(blockType);
 
                 for (int i = 0; i < 6; ++i)
                 {
-                    if (!texureFaceAllSame) {
-                        blockTexture = blockTextureData.getTexture(static_cast<BlockFace>(i));
-                        auto [uvMin, uvMax] = atlas.get(blockTexture);
-
-                        textureCoords = 
-                        {
-                            uvMin.x, uvMax.y,
-                            uvMax.x, uvMax.y,
-                            uvMax.x, uvMin.y,
-                            uvMin.x, uvMin.y
-                        };
-                    }
-
                     glm::ivec3 dir = static_cast<glm::ivec3>(DirectionUtils::blockfaceDirection(static_cast<BlockFace>(i)));
                     BlockType bType = snapshot.getBlockFromLocalPos(pos + dir);
                     if (shouldRenderFace(blockType, bType))
@@ -112,7 +246,8 @@ void ChunkMesh::buildMesh(const ChunkSnapshot& snapshot, const gfx::TextureAtlas
                         auto aoValues = getAOValues(pos, static_cast<BlockFace>(i), snapshot);
                         auto lightValues = getLightValues(pos, static_cast<BlockFace>(i), snapshot, smoothLighting);
                         bool flipQuad = shouldFlipQuad(aoValues);
-                        addFace(pos, static_cast<BlockFace>(i), textureCoords, aoValues, lightValues, layer, flipQuad);
+                        BlockTexture blockTexture = blockTextureData.getTexture(static_cast<BlockFace>(i));
+                        addFace(pos, static_cast<BlockFace>(i), blockTexture, aoValues, lightValues, layer, flipQuad);
                     }
                 }
             }
@@ -120,58 +255,205 @@ void ChunkMesh::buildMesh(const ChunkSnapshot& snapshot, const gfx::TextureAtlas
     }
 }
 
-void ChunkMesh::submitBuffers()
+void ChunkMesh::buildLodMesh(const ChunkSnapshot& snapshot)
 {
-    if (m_indexCounter != 0)
-        m_mesh.updateBuffers(m_vertices, m_indices);
-    if (m_indexCounterTranslucent != 0)
-        m_meshTranslucent.updateBuffers(m_verticesTranslucent, m_indicesTranslucent);
-    if (m_indexCounterTransparent != 0)
-        m_meshTransparent.updateBuffers(m_verticesTransparent, m_indicesTransparent);
+    const int scale = 1 << m_lod;
+    const int cells = Chunk::CHUNK_SIZE / scale;
+    const Chunk& chunk = *snapshot.center();
+
+    std::array<int8_t, 256> opaqueCache;
+    opaqueCache.fill(-1);
+    auto isOpaque = [&](BlockType type) {
+        size_t id = static_cast<size_t>(type);
+        if (id >= opaqueCache.size())
+            return BlockData::isOpaqueBlock(type);
+        if (opaqueCache[id] < 0)
+            opaqueCache[id] = BlockData::isOpaqueBlock(type) ? 1 : 0;
+        return opaqueCache[id] == 1;
+    };
+
+    // a cell takes its most common opaque block, or its most common other block if it has none
+    static thread_local std::vector<BlockType> cellBlocks;
+    cellBlocks.assign(cells * cells * cells, BlockType::Air);
+    auto cellIndex = [cells](const glm::ivec3& cell) { return (cell.x * cells + cell.y) * cells + cell.z; };
+    for (int cx = 0; cx < cells; ++cx)
+    {
+        for (int cy = 0; cy < cells; ++cy)
+        {
+            for (int cz = 0; cz < cells; ++cz)
+            {
+                struct BlockCount
+                {
+                    BlockType type;
+                    int count;
+                };
+                // cells rarely hold more than a few block types, extra types are ignored
+                std::array<BlockCount, 8> counts;
+                int typeCount = 0;
+                for (int x = cx * scale; x < (cx + 1) * scale; ++x)
+                {
+                    for (int y = cy * scale; y < (cy + 1) * scale; ++y)
+                    {
+                        for (int z = cz * scale; z < (cz + 1) * scale; ++z)
+                        {
+                            BlockType type = chunk.getBlock(x, y, z);
+                            if (type == BlockType::Air)
+                                continue;
+                            int i = 0;
+                            while (i < typeCount && counts[i].type != type)
+                                ++i;
+                            if (i < typeCount)
+                                ++counts[i].count;
+                            else if (typeCount < static_cast<int>(counts.size()))
+                                counts[typeCount++] = {type, 1};
+                        }
+                    }
+                }
+
+                BlockType cellBlock = BlockType::Air;
+                int bestCount = 0;
+                bool bestOpaque = false;
+                for (int i = 0; i < typeCount; ++i)
+                {
+                    bool opaque = isOpaque(counts[i].type);
+                    if ((opaque && !bestOpaque) || (opaque == bestOpaque && counts[i].count > bestCount))
+                    {
+                        cellBlock = counts[i].type;
+                        bestCount = counts[i].count;
+                        bestOpaque = opaque;
+                    }
+                }
+                cellBlocks[cellIndex({cx, cy, cz})] = cellBlock;
+            }
+        }
+    }
+
+    // scans the full resolution blocks just outside a cell face. Returns the brightest light
+    // among them and whether all of them hide the face
+    auto scanFace = [&](const glm::ivec3& cellMin, const glm::ivec3& dir, BlockType block, bool* outHidden) {
+        int axis = dir.x != 0 ? 0 : (dir.y != 0 ? 1 : 2);
+        int u = (axis + 1) % 3;
+        int v = (axis + 2) % 3;
+        glm::ivec3 slabMin = cellMin;
+        slabMin[axis] = dir[axis] > 0 ? cellMin[axis] + scale : cellMin[axis] - 1;
+
+        bool hidden = true;
+        uint16_t sunLight = 0;
+        uint16_t blockLight = 0;
+        for (int i = 0; i < scale; ++i)
+        {
+            for (int j = 0; j < scale; ++j)
+            {
+                glm::ivec3 samplePos = slabMin;
+                samplePos[u] += i;
+                samplePos[v] += j;
+                hidden = hidden && !shouldRenderFace(block, snapshot.getBlockFromLocalPos(samplePos));
+                sunLight = std::max(sunLight, snapshot.getSunLightFromLocalPos(samplePos));
+                blockLight = std::max(blockLight, snapshot.getBlockLightFromLocalPos(samplePos));
+            }
+        }
+        *outHidden = hidden;
+        return glm::vec4(0, 0, blockLight, sunLight);
+    };
+
+    // distant faces are too small for AO to be visible, so every corner is left unoccluded
+    const std::array<int, 4> noAO = {3, 3, 3, 3};
+    for (int cx = 0; cx < cells; ++cx)
+    {
+        for (int cy = 0; cy < cells; ++cy)
+        {
+            for (int cz = 0; cz < cells; ++cz)
+            {
+                glm::ivec3 cell{cx, cy, cz};
+                BlockType blockType = cellBlocks[cellIndex(cell)];
+                if (blockType == BlockType::Air)
+                    continue;
+
+                const BlockTextureData& blockTextureData = BlockData::getBlockTextureData(blockType);
+                RenderLayer layer = getRenderLayer(blockType);
+                glm::ivec3 cellMin = cell * scale;
+                for (int i = 0; i < 6; ++i)
+                {
+                    BlockFace face = static_cast<BlockFace>(i);
+                    glm::ivec3 dir = static_cast<glm::ivec3>(DirectionUtils::blockfaceDirection(face));
+                    glm::ivec3 neighbor = cell + dir;
+                    bool inChunk = neighbor.x >= 0 && neighbor.x < cells
+                        && neighbor.y >= 0 && neighbor.y < cells
+                        && neighbor.z >= 0 && neighbor.z < cells;
+                    if (inChunk && !shouldRenderFace(blockType, cellBlocks[cellIndex(neighbor)]))
+                        continue;
+
+                    bool hidden = false;
+                    glm::vec4 light = scanFace(cellMin, dir, blockType, &hidden);
+                    if (!inChunk && hidden)
+                        continue;
+                    addFace(cellMin, face, blockTextureData.getTexture(face), noAO, {light, light, light, light}, layer, false, scale);
+                }
+            }
+        }
+    }
 }
 
 void ChunkMesh::addFace
 (
     const glm::ivec3 &pos, 
     BlockFace face, 
-    std::array<float, 8> texCoords, 
+    BlockTexture texture, 
     std::array<int, 4> aoValues, 
     std::array<glm::vec4, 4> lightLevels, 
     RenderLayer layer,
-    bool flipQuad
+    bool flipQuad,
+    int scale
 )
 {
-    std::vector<float>* vertices;
-    std::vector<unsigned int>* indices;
-    unsigned int* indexCounter;
-    switch (layer)
+    int layerIndex = static_cast<int>(layer);
+    if (layerIndex < 0 || layerIndex >= ChunkMeshBuffers::LAYER_COUNT)
+        return; // Invalid layer
+    std::vector<uint32_t>* vertices = &m_buffers.layers[layerIndex];
+
+    if (m_format == ChunkMeshFormat::Faces)
     {
-        case RenderLayer::Opaque:
-            vertices = &m_vertices;
-            indices = &m_indices;
-            indexCounter = &m_indexCounter;
-            break;
-        case RenderLayer::Translucent:
-            vertices = &m_verticesTranslucent;
-            indices = &m_indicesTranslucent;
-            indexCounter = &m_indexCounterTranslucent;
-            break;
-        case RenderLayer::Transparent:
-            vertices = &m_verticesTransparent;
-            indices = &m_indicesTransparent;
-            indexCounter = &m_indexCounterTransparent;
-            break;
-        default:
-            return; // Invalid layer
+        // one record per face, expanded into a quad by terrain_chunk_faces.vert.
+        // The shader works out the flip from the AO values itself, and scales faces of
+        // coarser levels by the level stored in the page table
+        // each local position dimension can be packed into 5 bits (0-31)
+        uint32_t fPacked = pos.x;
+        fPacked = (fPacked << 5) + pos.y;
+        fPacked = (fPacked << 5) + pos.z;
+        // 3 bits for the normal index (0-7)
+        fPacked = (fPacked << 3) + static_cast<uint32_t>(face);
+        // 2 bits for the AO value of each corner, corner 0 in the lowest bits
+        for (int i = 3; i >= 0; --i)
+            fPacked = (fPacked << 2) + static_cast<uint32_t>(aoValues[i]);
+        // 6 bits for the texture index (0-63)
+        fPacked = (fPacked << 6) + static_cast<uint32_t>(texture);
+        vertices->push_back(fPacked);
+
+        // one byte of sun and block light per corner, corner 0 in the lowest byte
+        uint32_t lPacked = 0;
+        for (int i = 3; i >= 0; --i)
+        {
+            lPacked = (lPacked << 4) + static_cast<uint32_t>(lightLevels[i].a); // sun light
+            lPacked = (lPacked << 4) + static_cast<uint32_t>(lightLevels[i].b); // block light
+        }
+        vertices->push_back(lPacked);
+        return;
     }
 
+    // quads are drawn with a shared index buffer that always splits them along the 0-2 diagonal.
+    // Starting from the next vertex splits the quad along the 1-3 diagonal instead
+    int startVertex = flipQuad ? 1 : 0;
+
     auto faceCoords = getFaceCoords(face);
-    for (int i = 0, vertIndex = 0, texIndex = 0; i < 4; ++i)
+    for (int n = 0; n < 4; ++n)
     {
-        // each local position dimension can be packed into 6 bits (0-63)
-        uint32_t vPacked = pos.x + faceCoords[vertIndex++];
-        vPacked = (vPacked << 6) + pos.y + faceCoords[vertIndex++];
-        vPacked = (vPacked << 6) + pos.z + faceCoords[vertIndex++];
+        int i = (startVertex + n) % 4;
+        int vertIndex = i * 3;
+        // each local position dimension can be packed into 6 bits (0-63).
+        // Corners of coarser levels are scaled here, so they still end at most at CHUNK_SIZE
+        uint32_t vPacked = pos.x + faceCoords[vertIndex++] * scale;
+        vPacked = (vPacked << 6) + pos.y + faceCoords[vertIndex++] * scale;
+        vPacked = (vPacked << 6) + pos.z + faceCoords[vertIndex++] * scale;
         // 3 bits for the normal index (0-7)
         vPacked = (vPacked << 3) + static_cast<uint32_t>(face);
         // 2 bits for the AO value (0-3)
@@ -179,34 +461,11 @@ void ChunkMesh::addFace
         // 4 bits for the light levels (0-15)
         vPacked = (vPacked << 4) + static_cast<uint32_t>(lightLevels[i].a); // sun light
         vPacked = (vPacked << 4) + static_cast<uint32_t>(lightLevels[i].b); // block light
-        vertices->push_back(std::bit_cast<float>(vPacked));
-
-        vertices->push_back(texCoords[texIndex++]);
-        vertices->push_back(texCoords[texIndex++]);
-    }
-
-    if (flipQuad)
-    {
-        indices->push_back(*indexCounter + 3);
-        indices->push_back(*indexCounter + 0);
-        indices->push_back(*indexCounter + 1);
-
-        indices->push_back(*indexCounter + 1);
-        indices->push_back(*indexCounter + 2);
-        indices->push_back(*indexCounter + 3);
-    }
-    else
-    {
-        indices->push_back(*indexCounter + 0);
-        indices->push_back(*indexCounter + 1);
-        indices->push_back(*indexCounter + 2);
+        vertices->push_back(vPacked);
 
-        indices->push_back(*indexCounter + 2);
-        indices->push_back(*indexCounter + 3);
-        indices->push_back(*indexCounter + 0);
+        // the shader derives texture coordinates from the position, so only the texture index is stored
+        vertices->push_back(static_cast<uint32_t>(texture));
     }
-
-    (*indexCounter) += 4;
 }
 
 std::array<int, 12> ChunkMesh::getFaceCoords(BlockFace face)
@@ -0,0 +1,304 @@
+#include "graphics/chunk_mesh_arena.h"
+#include "world/chunk.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+ChunkMeshArena::~ChunkMeshArena()
+{
+    destroy();
+}
+
+void ChunkMeshArena::setup(ChunkMeshFormat format)
+{
+    destroy();
+    m_format = format;
+    m_elementsPerQuad = format == ChunkMeshFormat::Faces ? 1 : VERTICES_PER_QUAD;
+    m_elementArena.setup(WORDS_PER_ELEMENT * sizeof(uint32_t), INITIAL_ELEMENT_CAPACITY, PAGE_ELEMENTS);
+    glGenVertexArrays(1, &m_vao);
+    if (m_format == ChunkMeshFormat::Faces)
+        glGenTextures(1, &m_faceTexture);
+    setupQuadIndexBuffer();
+    attachBuffers();
+
+    glGenBuffers(1, &m_pageBuffer);
+    glGenTextures(1, &m_pageTexture);
+    rebuildPageTable();
+
+#ifdef GL_VERSION_4_3
+    m_useIndirect = GLAD_GL_VERSION_4_3;
+#endif
+    if (m_useIndirect)
+        glGenBuffers(1, &m_indirectBuffer);
+    spdlog::info("ChunkMeshArena: using {} for chunk draws.", m_useIndirect ? "glMultiDrawElementsIndirect" : "glMultiDrawElementsBaseVertex");
+}
+
+ChunkMeshArena::Region ChunkMeshArena::allocate(const glm::ivec3& chunkPos, const std::vector<uint32_t>& data, int lod)
+{
+    Region region;
+    if (data.empty())
+        return region;
+
+    size_t elementCount = data.size() / WORDS_PER_ELEMENT;
+    unsigned int prevElementBuffer = m_elementArena.getID();
+    region.elements = m_elementArena.allocate(elementCount);
+    if (region.elements == gfx::BufferArena::INVALID_HANDLE)
+    {
+        spdlog::error("ChunkMeshArena: failed to allocate chunk mesh.");
+        return region;
+    }
+    m_elementArena.upload(region.elements, data.data(), elementCount);
+    region.quadCount = static_cast<unsigned int>(elementCount / m_elementsPerQuad);
+
+    glm::ivec4 page(chunkPos * Chunk::CHUNK_SIZE, lod);
+    m_elementOwners[region.elements] = page;
+    // growing or compacting the arena moves every block, so all pages need to be rewritten
+    if (prevElementBuffer != m_elementArena.getID())
+        rebuildPageTable();
+    else
+        writePages(region.elements, page);
+    return region;
+}
+
+void ChunkMeshArena::free(Region& region)
+{
+    m_elementOwners.erase(region.elements);
+    m_elementArena.free(region.elements);
+    region = Region();
+}
+
+void ChunkMeshArena::update(const Region& region, const std::vector<uint32_t>& data)
+{
+    if (!region.isValid() || data.size() != region.quadCount * m_elementsPerQuad * WORDS_PER_ELEMENT)
+    {
+        spdlog::error("ChunkMeshArena: region update does not match the region size.");
+        return;
+    }
+    m_elementArena.upload(region.elements, data.data(), data.size() / WORDS_PER_ELEMENT);
+}
+
+void ChunkMeshArena::read(const Region& region, std::vector<uint32_t>& data) const
+{
+    data.resize(static_cast<size_t>(region.quadCount) * m_elementsPerQuad * WORDS_PER_ELEMENT);
+    if (region.isValid())
+        m_elementArena.download(region.elements, data.data(), data.size() / WORDS_PER_ELEMENT);
+}
+
+void ChunkMeshArena::bind()
+{
+    if (m_boundElementBuffer != m_elementArena.getID())
+        attachBuffers();
+    if (m_pageTableDirty)
+        uploadPageTable();
+
+    glActiveTexture(GL_TEXTURE0 + PAGE_TABLE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, m_pageTexture);
+    if (m_format == ChunkMeshFormat::Faces)
+    {
+        glActiveTexture(GL_TEXTURE0 + FACE_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, m_faceTexture);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(m_vao);
+}
+
+void ChunkMeshArena::clearBatch()
+{
+    m_indirectCommands.clear();
+    m_batchCounts.clear();
+    m_batchBaseVertices.clear();
+}
+
+void ChunkMeshArena::addToBatch(const Region& region)
+{
+    GLint baseVertex = getBaseVertex(region);
+    for (unsigned int quad = 0; quad < region.quadCount; quad += MAX_QUADS_PER_DRAW)
+    {
+        unsigned int quadCount = std::min<unsigned int>(region.quadCount - quad, MAX_QUADS_PER_DRAW);
+        GLint drawBaseVertex = baseVertex + quad * VERTICES_PER_QUAD;
+        if (m_useIndirect)
+        {
+            m_indirectCommands.push_back({quadCount * INDICES_PER_QUAD, 1, 0, drawBaseVertex, 0});
+        }
+        else
+        {
+            m_batchCounts.push_back(static_cast<GLsizei>(quadCount * INDICES_PER_QUAD));
+            m_batchBaseVertices.push_back(drawBaseVertex);
+        }
+    }
+}
+
+int ChunkMeshArena::drawBatch()
+{
+#ifdef GL_VERSION_4_3
+    if (m_useIndirect)
+    {
+        if (m_indirectCommands.empty())
+            return 0;
+        size_t size = m_indirectCommands.size() * sizeof(DrawElementsIndirectCommand);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+        if (size > m_indirectBufferSize)
+        {
+            m_indirectBufferSize = size * 2;
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, m_indirectBufferSize, nullptr, GL_STREAM_DRAW);
+        }
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, m_indirectCommands.data());
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, static_cast<GLsizei>(m_indirectCommands.size()), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        return 1;
+    }
+#endif
+    if (m_batchCounts.empty())
+        return 0;
+    if (m_batchIndexOffsets.size() < m_batchCounts.size())
+        m_batchIndexOffsets.resize(m_batchCounts.size(), nullptr);
+    glMultiDrawElementsBaseVertex(
+        GL_TRIANGLES,
+        m_batchCounts.data(),
+        GL_UNSIGNED_SHORT,
+        m_batchIndexOffsets.data(),
+        static_cast<GLsizei>(m_batchCounts.size()),
+        m_batchBaseVertices.data()
+    );
+    return 1;
+}
+
+bool ChunkMeshArena::defragment()
+{
+    bool moved = m_elementArena.defragment();
+    if (moved)
+        rebuildPageTable();
+    return moved;
+}
+
+void ChunkMeshArena::destroy()
+{
+    if (m_vao)
+        glDeleteVertexArrays(1, &m_vao);
+    if (m_quadIndexBuffer)
+        glDeleteBuffers(1, &m_quadIndexBuffer);
+    if (m_faceTexture)
+        glDeleteTextures(1, &m_faceTexture);
+    if (m_pageTexture)
+        glDeleteTextures(1, &m_pageTexture);
+    if (m_pageBuffer)
+        glDeleteBuffers(1, &m_pageBuffer);
+    if (m_indirectBuffer)
+        glDeleteBuffers(1, &m_indirectBuffer);
+    m_vao = 0;
+    m_quadIndexBuffer = 0;
+    m_faceTexture = 0;
+    m_pageTexture = 0;
+    m_pageBuffer = 0;
+    m_pageBufferSize = 0;
+    m_indirectBuffer = 0;
+    m_indirectBufferSize = 0;
+    m_boundElementBuffer = 0;
+    m_elementOwners.clear();
+    m_pageTable.clear();
+    m_elementArena.destroy();
+}
+
+size_t ChunkMeshArena::getCapacityBytes() const
+{
+    return m_elementArena.getCapacity() * m_elementArena.getElementSize();
+}
+
+size_t ChunkMeshArena::getUsedBytes() const
+{
+    return m_elementArena.getUsed() * m_elementArena.getElementSize();
+}
+
+size_t ChunkMeshArena::getFreeBlockCount() const
+{
+    return m_elementArena.getFreeBlockCount();
+}
+
+void ChunkMeshArena::setupQuadIndexBuffer()
+{
+    // quads are always split along the 0-2 diagonal. Quads that need to be split along the
+    // other diagonal for AO have their corners rotated, by ChunkMesh for vertices and by the
+    // vertex shader for faces
+    std::vector<uint16_t> indices;
+    indices.reserve(MAX_QUADS_PER_DRAW * INDICES_PER_QUAD);
+    for (int quad = 0; quad < MAX_QUADS_PER_DRAW; ++quad)
+    {
+        uint16_t first = static_cast<uint16_t>(quad * VERTICES_PER_QUAD);
+        indices.push_back(first + 0);
+        indices.push_back(first + 1);
+        indices.push_back(first + 2);
+
+        indices.push_back(first + 2);
+        indices.push_back(first + 3);
+        indices.push_back(first + 0);
+    }
+
+    glBindVertexArray(m_vao);
+    glGenBuffers(1, &m_quadIndexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_quadIndexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+void ChunkMeshArena::attachBuffers()
+{
+    if (m_format == ChunkMeshFormat::Faces)
+    {
+        // faces are fetched by the shader, so the VAO only holds the quad indices
+        glBindTexture(GL_TEXTURE_BUFFER, m_faceTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, m_elementArena.getID());
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    else
+    {
+        glBindVertexArray(m_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_elementArena.getID());
+        glVertexAttribIPointer(0, WORDS_PER_ELEMENT, GL_UNSIGNED_INT, WORDS_PER_ELEMENT * sizeof(uint32_t), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+    }
+
+    m_boundElementBuffer = m_elementArena.getID();
+}
+
+void ChunkMeshArena::writePages(gfx::BufferArena::Handle elements, const glm::ivec4& page)
+{
+    size_t firstPage = m_elementArena.getOffset(elements) / PAGE_ELEMENTS;
+    size_t pageCount = m_elementArena.getSize(elements) / PAGE_ELEMENTS;
+    for (size_t i = firstPage; i < firstPage + pageCount; ++i)
+        m_pageTable[i] = page;
+    m_pageTableDirty = true;
+}
+
+GLint ChunkMeshArena::getBaseVertex(const Region& region) const
+{
+    // a face expands into 4 vertices, so the base vertex of a face record is 4 times its offset
+    return static_cast<GLint>(m_elementArena.getOffset(region.elements) * (VERTICES_PER_QUAD / m_elementsPerQuad));
+}
+
+void ChunkMeshArena::rebuildPageTable()
+{
+    m_pageTable.assign(m_elementArena.getCapacity() / PAGE_ELEMENTS, glm::ivec4(0));
+    for (const auto& [handle, page] : m_elementOwners)
+        writePages(handle, page);
+    m_pageTableDirty = true;
+}
+
+void ChunkMeshArena::uploadPageTable()
+{
+    size_t size = m_pageTable.size() * sizeof(glm::ivec4);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_pageBuffer);
+    if (size != m_pageBufferSize)
+    {
+        glBufferData(GL_TEXTURE_BUFFER, size, m_pageTable.data(), GL_DYNAMIC_DRAW);
+        m_pageBufferSize = size;
+        glBindTexture(GL_TEXTURE_BUFFER, m_pageTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32I, m_pageBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    else
+    {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, size, m_pageTable.data());
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    m_pageTableDirty = false;
+}
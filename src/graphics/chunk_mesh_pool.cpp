@@ -0,0 +1,97 @@
+#include "graphics/chunk_mesh_pool.h"
+
+std::shared_ptr<ChunkMesh> ChunkMeshPool::acquire()
+{
+    std::shared_ptr<ChunkMesh> mesh;
+    ChunkMeshBuffers buffers;
+    bool needsBuffers = true;
+    bool hasBuffers = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_meshes.empty())
+        {
+            mesh = std::move(m_meshes.back());
+            m_meshes.pop_back();
+            // a mesh dropped before it was uploaded still holds its buffers
+            needsBuffers = mesh->getCPUMemoryUsage() == 0;
+        }
+        if (needsBuffers && !m_buffers.empty())
+        {
+            buffers = std::move(m_buffers.back());
+            m_buffers.pop_back();
+            hasBuffers = true;
+        }
+    }
+
+    if (!mesh)
+    {
+        mesh = std::make_shared<ChunkMesh>();
+        ++m_meshAllocations;
+    }
+    if (hasBuffers)
+        mesh->setBuffers(std::move(buffers));
+    else if (needsBuffers)
+        ++m_bufferAllocations;
+    return mesh;
+}
+
+void ChunkMeshPool::release(std::shared_ptr<ChunkMesh>&& mesh)
+{
+    if (!mesh || mesh.use_count() > 1)
+        return;
+    mesh->releaseRegions();
+    mesh->releaseTranslucentFaces();
+    mesh->clearMesh();
+    if (mesh->getCPUMemoryUsage() > MAX_POOLED_BUFFER_BYTES)
+        mesh->releaseCPUData();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_meshes.size() < MAX_POOLED_MESHES)
+        m_meshes.push_back(std::move(mesh));
+    mesh.reset();
+}
+
+void ChunkMeshPool::releaseBuffers(ChunkMesh& mesh)
+{
+    ChunkMeshBuffers buffers = mesh.takeBuffers();
+    if (buffers.getCapacityBytes() == 0 || buffers.getCapacityBytes() > MAX_POOLED_BUFFER_BYTES)
+        return;
+    buffers.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_buffers.size() < MAX_POOLED_BUFFERS)
+        m_buffers.push_back(std::move(buffers));
+}
+
+void ChunkMeshPool::recordBuild(bool grewBuffers)
+{
+    ++m_builds;
+    if (grewBuffers)
+        ++m_bufferGrowths;
+}
+
+void ChunkMeshPool::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_meshes.clear();
+    m_buffers.clear();
+}
+
+ChunkMeshPoolStats ChunkMeshPool::getStats() const
+{
+    ChunkMeshPoolStats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.pooledMeshes = m_meshes.size();
+        stats.pooledBuffers = m_buffers.size();
+        for (const auto& mesh : m_meshes)
+            stats.pooledBytes += sizeof(ChunkMesh) + mesh->getCPUMemoryUsage();
+        for (const auto& buffers : m_buffers)
+            stats.pooledBytes += buffers.getCapacityBytes();
+    }
+    stats.builds = m_builds;
+    stats.meshAllocations = m_meshAllocations;
+    stats.bufferAllocations = m_bufferAllocations;
+    stats.bufferGrowths = m_bufferGrowths;
+    return stats;
+}
@@ -0,0 +1,153 @@
+#include "graphics/chunk_visibility.h"
+#include <array>
+#include <vector>
+
+namespace
+{
+    const int CHUNK_VOLUME = Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE;
+
+    // neighbor offsets indexed by BlockFace
+    const std::array<glm::ivec3, ChunkVisibility::FACE_COUNT> FACE_OFFSETS = {
+        glm::ivec3{0, 1, 0}, glm::ivec3{0, -1, 0},
+        glm::ivec3{0, 0, 1}, glm::ivec3{0, 0, -1},
+        glm::ivec3{-1, 0, 0}, glm::ivec3{1, 0, 0}
+    };
+
+    // same x, z, y order as the chunk's block storage
+    int blockIndex(int x, int y, int z)
+    {
+        return x * Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE + z * Chunk::CHUNK_SIZE + y;
+    }
+
+    // bit mask of the chunk faces a block touches
+    uint8_t touchedFaces(int x, int y, int z)
+    {
+        const int last = Chunk::CHUNK_SIZE - 1;
+        uint8_t faces = 0;
+        if (y == last) faces |= 1 << static_cast<int>(BlockFace::Top);
+        if (y == 0) faces |= 1 << static_cast<int>(BlockFace::Bottom);
+        if (z == last) faces |= 1 << static_cast<int>(BlockFace::Front);
+        if (z == 0) faces |= 1 << static_cast<int>(BlockFace::Back);
+        if (x == 0) faces |= 1 << static_cast<int>(BlockFace::Left);
+        if (x == last) faces |= 1 << static_cast<int>(BlockFace::Right);
+        return faces;
+    }
+}
+
+ChunkVisibility ChunkVisibility::allVisible()
+{
+    ChunkVisibility visibility;
+    visibility.m_connections = (uint64_t(1) << (FACE_COUNT * FACE_COUNT)) - 1;
+    return visibility;
+}
+
+void ChunkVisibility::compute(const Chunk& chunk)
+{
+    m_connections = 0;
+    if (chunk.isAllAir())
+    {
+        *this = allVisible();
+        return;
+    }
+
+    // BlockData lookups go through a map, so cache the opacity of each block type
+    std::array<int8_t, 256> opaqueCache;
+    opaqueCache.fill(-1);
+    auto isOpaque = [&](BlockType type) {
+        uint16_t id = static_cast<uint16_t>(type);
+        if (id >= opaqueCache.size())
+            return BlockData::isOpaqueBlock(type);
+        if (opaqueCache[id] < 0)
+            opaqueCache[id] = BlockData::isOpaqueBlock(type) ? 1 : 0;
+        return opaqueCache[id] == 1;
+    };
+
+    // reused by every chunk built on this thread
+    thread_local std::vector<uint8_t> visited;
+    thread_local std::vector<int> stack;
+    visited.assign(CHUNK_VOLUME, 0);
+
+    auto fill = [&](int startX, int startY, int startZ) {
+        int startIndex = blockIndex(startX, startY, startZ);
+        if (visited[startIndex] || isOpaque(chunk.getBlock(startX, startY, startZ)))
+            return;
+
+        uint8_t faces = 0;
+        visited[startIndex] = 1;
+        stack.clear();
+        stack.push_back(startIndex);
+        while (!stack.empty())
+        {
+            int index = stack.back();
+            stack.pop_back();
+            int x = index / (Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE);
+            int z = (index / Chunk::CHUNK_SIZE) % Chunk::CHUNK_SIZE;
+            int y = index % Chunk::CHUNK_SIZE;
+            faces |= touchedFaces(x, y, z);
+
+            for (int i = 0; i < FACE_COUNT; ++i)
+            {
+                glm::ivec3 n = glm::ivec3(x, y, z) + FACE_OFFSETS[i];
+                if (n.x < 0 || n.x >= Chunk::CHUNK_SIZE || n.y < 0 || n.y >= Chunk::CHUNK_SIZE || n.z < 0 || n.z >= Chunk::CHUNK_SIZE)
+                    continue;
+                int neighborIndex = blockIndex(n.x, n.y, n.z);
+                if (visited[neighborIndex] || isOpaque(chunk.getBlock(n)))
+                    continue;
+                visited[neighborIndex] = 1;
+                stack.push_back(neighborIndex);
+            }
+        }
+
+        for (int a = 0; a < FACE_COUNT; ++a)
+        {
+            if (!(faces & (1 << a)))
+                continue;
+            for (int b = 0; b < FACE_COUNT; ++b)
+            {
+                if (faces & (1 << b))
+                    connect(static_cast<BlockFace>(a), static_cast<BlockFace>(b));
+            }
+        }
+    };
+
+    // pockets that do not touch the chunk's faces cannot connect anything, so only
+    // start filling from blocks on the faces
+    const int last = Chunk::CHUNK_SIZE - 1;
+    for (int a = 0; a < Chunk::CHUNK_SIZE; ++a)
+    {
+        for (int b = 0; b < Chunk::CHUNK_SIZE; ++b)
+        {
+            fill(0, a, b);
+            fill(last, a, b);
+            fill(a, 0, b);
+            fill(a, last, b);
+            fill(a, b, 0);
+            fill(a, b, last);
+        }
+    }
+}
+
+bool ChunkVisibility::canSeeThrough(BlockFace from, BlockFace to) const
+{
+    return m_connections & (uint64_t(1) << (static_cast<int>(from) * FACE_COUNT + static_cast<int>(to)));
+}
+
+bool ChunkVisibility::isOpaque() const
+{
+    // pockets touching a single face only connect that face to itself
+    for (int a = 0; a < FACE_COUNT; ++a)
+    {
+        for (int b = a + 1; b < FACE_COUNT; ++b)
+        {
+            if (canSeeThrough(static_cast<BlockFace>(a), static_cast<BlockFace>(b)))
+                return false;
+        }
+    }
+    return true;
+}
+
+void ChunkVisibility::connect(BlockFace a, BlockFace b)
+{
+    m_connections |= uint64_t(1) << (static_cast<int>(a) * FACE_COUNT + static_cast<int>(b));
+    m_connections |= uint64_t(1) << (static_cast<int>(b) * FACE_COUNT + static_cast<int>(a));
+}
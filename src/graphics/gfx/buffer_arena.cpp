@@ -0,0 +1,264 @@
+#include "graphics/gfx/buffer_arena.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace gfx
+{
+    BufferArena::~BufferArena()
+    {
+        destroy();
+    }
+
+    BufferArena::BufferArena(BufferArena&& other) noexcept
+    {
+        m_id = other.m_id;
+        m_elementSize = other.m_elementSize;
+        m_alignment = other.m_alignment;
+        m_capacity = other.m_capacity;
+        m_used = other.m_used;
+        m_usage = other.m_usage;
+        m_blocks = std::move(other.m_blocks);
+        m_freeHandles = std::move(other.m_freeHandles);
+        m_freeBlocks = std::move(other.m_freeBlocks);
+
+        other.m_id = 0;
+        other.m_capacity = 0;
+        other.m_used = 0;
+    }
+
+    BufferArena& BufferArena::operator=(BufferArena&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_id = other.m_id;
+            m_elementSize = other.m_elementSize;
+            m_alignment = other.m_alignment;
+            m_capacity = other.m_capacity;
+            m_used = other.m_used;
+            m_usage = other.m_usage;
+            m_blocks = std::move(other.m_blocks);
+            m_freeHandles = std::move(other.m_freeHandles);
+            m_freeBlocks = std::move(other.m_freeBlocks);
+
+            other.m_id = 0;
+            other.m_capacity = 0;
+            other.m_used = 0;
+        }
+        return *this;
+    }
+
+    void BufferArena::setup(size_t elementSize, size_t initialCapacity, size_t alignment, GLenum usage)
+    {
+        destroy();
+        m_elementSize = elementSize;
+        m_alignment = std::max<size_t>(alignment, 1);
+        m_capacity = (std::max<size_t>(initialCapacity, 1) + m_alignment - 1) / m_alignment * m_alignment;
+        m_usage = usage;
+
+        glGenBuffers(1, &m_id);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_id);
+        glBufferData(GL_COPY_WRITE_BUFFER, m_capacity * m_elementSize, nullptr, m_usage);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        m_freeBlocks[0] = m_capacity;
+    }
+
+    BufferArena::Handle BufferArena::allocate(size_t count)
+    {
+        if (count == 0 || m_id == 0)
+            return INVALID_HANDLE;
+        count = (count + m_alignment - 1) / m_alignment * m_alignment;
+
+        size_t offset;
+        if (!allocateFromFreeList(count, &offset))
+        {
+            size_t freeSpace = m_capacity - m_used;
+            if (freeSpace >= count)
+                compact();
+            else
+                reallocate(std::max(m_capacity * 2, m_used + count));
+            allocateFromFreeList(count, &offset);
+        }
+
+        Handle handle;
+        if (!m_freeHandles.empty())
+        {
+            handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+        }
+        else
+        {
+            handle = static_cast<Handle>(m_blocks.size());
+            m_blocks.emplace_back();
+        }
+        m_blocks[handle] = {offset, count, true};
+        m_used += count;
+        return handle;
+    }
+
+    void BufferArena::upload(Handle handle, const void* data, size_t count)
+    {
+        if (handle == INVALID_HANDLE || !m_blocks[handle].used)
+        {
+            spdlog::warn("BufferArena: upload to an invalid handle.");
+            return;
+        }
+        const Block& block = m_blocks[handle];
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_id);
+        glBufferSubData(
+            GL_COPY_WRITE_BUFFER,
+            block.offset * m_elementSize,
+            std::min(count, block.size) * m_elementSize,
+            data
+        );
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    void BufferArena::download(Handle handle, void* data, size_t count) const
+    {
+        if (handle == INVALID_HANDLE || !m_blocks[handle].used)
+        {
+            spdlog::warn("BufferArena: download from an invalid handle.");
+            return;
+        }
+        const Block& block = m_blocks[handle];
+        glBindBuffer(GL_COPY_READ_BUFFER, m_id);
+        glGetBufferSubData(
+            GL_COPY_READ_BUFFER,
+            block.offset * m_elementSize,
+            std::min(count, block.size) * m_elementSize,
+            data
+        );
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+
+    void BufferArena::free(Handle handle)
+    {
+        if (handle == INVALID_HANDLE || handle >= m_blocks.size() || !m_blocks[handle].used)
+            return;
+
+        Block& block = m_blocks[handle];
+        size_t offset = block.offset;
+        size_t size = block.size;
+        m_used -= size;
+        block.used = false;
+        m_freeHandles.push_back(handle);
+
+        // merge with the free blocks on either side
+        auto next = m_freeBlocks.lower_bound(offset);
+        if (next != m_freeBlocks.end() && offset + size == next->first)
+        {
+            size += next->second;
+            next = m_freeBlocks.erase(next);
+        }
+        if (next != m_freeBlocks.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                prev->second += size;
+                return;
+            }
+        }
+        m_freeBlocks[offset] = size;
+    }
+
+    bool BufferArena::defragment()
+    {
+        size_t freeSpace = m_capacity - m_used;
+        if (m_freeBlocks.size() < 16 || freeSpace < m_capacity / 4)
+            return false;
+        if (getLargestFreeBlock() >= freeSpace / 2)
+            return false;
+        compact();
+        return true;
+    }
+
+    void BufferArena::compact()
+    {
+        reallocate(m_capacity);
+    }
+
+    void BufferArena::destroy()
+    {
+        if (m_id)
+            glDeleteBuffers(1, &m_id);
+        m_id = 0;
+        m_capacity = 0;
+        m_used = 0;
+        m_blocks.clear();
+        m_freeHandles.clear();
+        m_freeBlocks.clear();
+    }
+
+    size_t BufferArena::getLargestFreeBlock() const
+    {
+        size_t largest = 0;
+        for (const auto& [offset, size] : m_freeBlocks)
+            largest = std::max(largest, size);
+        return largest;
+    }
+
+    bool BufferArena::allocateFromFreeList(size_t count, size_t* outOffset)
+    {
+        for (auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it)
+        {
+            if (it->second < count)
+                continue;
+            size_t offset = it->first;
+            size_t remaining = it->second - count;
+            m_freeBlocks.erase(it);
+            if (remaining > 0)
+                m_freeBlocks[offset + count] = remaining;
+            *outOffset = offset;
+            return true;
+        }
+        return false;
+    }
+
+    void BufferArena::reallocate(size_t newCapacity)
+    {
+        unsigned int newID;
+        glGenBuffers(1, &newID);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newID);
+        glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * m_elementSize, nullptr, m_usage);
+        glBindBuffer(GL_COPY_READ_BUFFER, m_id);
+
+        // copy blocks in offset order so the packed layout keeps their relative order
+        std::vector<Handle> liveHandles;
+        for (Handle i = 0; i < m_blocks.size(); ++i)
+        {
+            if (m_blocks[i].used)
+                liveHandles.push_back(i);
+        }
+        std::sort(liveHandles.begin(), liveHandles.end(), [this](Handle a, Handle b) {
+            return m_blocks[a].offset < m_blocks[b].offset;
+        });
+
+        size_t packedOffset = 0;
+        for (Handle handle : liveHandles)
+        {
+            Block& block = m_blocks[handle];
+            glCopyBufferSubData(
+                GL_COPY_READ_BUFFER,
+                GL_COPY_WRITE_BUFFER,
+                block.offset * m_elementSize,
+                packedOffset * m_elementSize,
+                block.size * m_elementSize
+            );
+            block.offset = packedOffset;
+            packedOffset += block.size;
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &m_id);
+
+        m_id = newID;
+        m_capacity = newCapacity;
+        m_freeBlocks.clear();
+        if (packedOffset < m_capacity)
+            m_freeBlocks[packedOffset] = m_capacity - packedOffset;
+    }
+}
@@ -1,5 +1,6 @@
 #include "graphics/gfx/font_renderer.h"
 #include <glad/glad.h>
+#include <type_traits>
 
 namespace gfx
 {
@@ -36,15 +37,19 @@ namespace gfx
         : m_fontSize(other.m_fontSize),
           m_vertices(std::move(other.m_vertices)),
           m_verticesBB(std::move(other.m_verticesBB)),
-          m_indices(std::move(other.m_indices)),
-          m_curVertex(other.m_curVertex),
-          m_curIndex(other.m_curIndex),
+          m_glyphCount(other.m_glyphCount),
+          m_quadIndexCapacity(other.m_quadIndexCapacity),
           m_textureAtlas(std::move(other.m_textureAtlas)),
-          m_characters(std::move(other.m_characters)),
-          m_batchMesh(std::move(other.m_batchMesh)),
+          m_directGlyphs(other.m_directGlyphs),
+          m_overflowGlyphs(std::move(other.m_overflowGlyphs)),
+          m_stream(std::move(other.m_stream)),
           m_meshInitialized(other.m_meshInitialized),
+          m_useBillboard(other.m_useBillboard),
           m_face(other.m_face)
     {
+        other.m_glyphCount = 0;
+        other.m_quadIndexCapacity = 0;
+        other.m_meshInitialized = false;
         other.m_face = nullptr;
     }
 
@@ -52,18 +57,24 @@ namespace gfx
     {
         if (this != &other)
         {
+            if (m_face)
+                FT_Done_Face(m_face);
             m_fontSize = other.m_fontSize;
             m_vertices = std::move(other.m_vertices);
             m_verticesBB = std::move(other.m_verticesBB);
-            m_indices = std::move(other.m_indices);
-            m_curVertex = other.m_curVertex;
-            m_curIndex = other.m_curIndex;
+            m_glyphCount = other.m_glyphCount;
+            m_quadIndexCapacity = other.m_quadIndexCapacity;
             m_textureAtlas = std::move(other.m_textureAtlas);
-            m_characters = std::move(other.m_characters);
-            m_batchMesh = std::move(other.m_batchMesh);
+            m_directGlyphs = other.m_directGlyphs;
+            m_overflowGlyphs = std::move(other.m_overflowGlyphs);
+            m_stream = std::move(other.m_stream);
             m_meshInitialized = other.m_meshInitialized;
+            m_useBillboard = other.m_useBillboard;
             m_face = other.m_face;
             
+            other.m_glyphCount = 0;
+            other.m_quadIndexCapacity = 0;
+            other.m_meshInitialized = false;
             other.m_face = nullptr;
         }
         return *this;
@@ -85,267 +96,218 @@ namespace gfx
 
     void FontRenderer::preloadGlyphs(const std::wstring &text)
     {
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        for (wchar_t c : text)
-        {
-            if (FT_Load_Char(m_face, c, FT_LOAD_RENDER))
-                continue;
-            
-            if (!m_textureAtlas.has(c)) {
-                if (!setupGlyph(c, m_face->glyph))
-                    continue;
-                m_characters[c] = {
-                    glm::ivec2(m_face->glyph->bitmap.width, m_face->glyph->bitmap.rows),
-                    glm::ivec2(m_face->glyph->bitmap_left, m_face->glyph->bitmap_top),
-                    static_cast<unsigned int>(m_face->glyph->advance.x >> 6)
-                };
-            }
-        }
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        addGlyphs(rasterizeGlyphs(text));
     }
 
     void FontRenderer::preloadGlyphs(const std::string &text)
     {
-        std::wstring wText(text.begin(), text.end());
+        std::wstring wText;
+        wText.reserve(text.size());
+        for (char c : text)
+            wText.push_back(static_cast<wchar_t>(static_cast<unsigned char>(c)));
         preloadGlyphs(wText);
     }
 
     void FontRenderer::preloadDefaultGlyphs()
     {
-        static std::wstring defaultGlyphs = L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789!@#$%^&*()_+-=[]{}|;':\",.<>?/`~ ";
-        preloadGlyphs(defaultGlyphs);
+        preloadGlyphs(getDefaultGlyphs());
+    }
+
+    const std::wstring& FontRenderer::getDefaultGlyphs()
+    {
+        static const std::wstring defaultGlyphs = L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789!@#$%^&*()_+-=[]{}|;':\",.<>?/`~ ";
+        return defaultGlyphs;
     }
 
-    void FontRenderer::beginBatch()
+    std::vector<Glyph> FontRenderer::rasterizeGlyphs(const std::wstring &text)
+    {
+        std::vector<Glyph> glyphs;
+        for (wchar_t c : text)
+        {
+            if (findGlyph(static_cast<char32_t>(c)) || FT_Load_Char(m_face, c, FT_LOAD_RENDER))
+                continue;
+            glyphs.push_back(makeGlyph(static_cast<char32_t>(c), m_face->glyph));
+        }
+        return glyphs;
+    }
+
+    void FontRenderer::addGlyphs(const std::vector<Glyph> &glyphs)
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (const Glyph& glyph : glyphs)
+            addGlyph(glyph);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    void FontRenderer::beginBatch(size_t expectedGlyphs)
     {
         if (!m_meshInitialized)
         {
             if (m_useBillboard)
-                m_batchMesh.populate({}, {}, { 3, 3, 4, 2 }, GL_DYNAMIC_DRAW, GL_DYNAMIC_DRAW);
+                m_stream.setup({ 3, 3, 4, 2 });
             else
-                m_batchMesh.populate({}, {}, { 3, 4, 2 }, GL_DYNAMIC_DRAW, GL_DYNAMIC_DRAW);
+                m_stream.setup({ 3, 4, 2 });
             m_meshInitialized = true;
+            m_quadIndexCapacity = 0;
         }
-        m_curVertex = 0;
-        m_curIndex = 0;
+        // clear keeps the capacity, so steady batches reuse the same storage every frame
+        m_vertices.clear();
+        m_verticesBB.clear();
+        m_glyphCount = 0;
+        if (m_useBillboard)
+            m_verticesBB.reserve(expectedGlyphs * 4);
+        else
+            m_vertices.reserve(expectedGlyphs * 4);
     }
 
-    void FontRenderer::addText(const std::wstring &text, float x, float y, float scale, const glm::vec4 &color, bool center)
+    void FontRenderer::addText(std::string_view text, float x, float y, float scale, const glm::vec4 &color, bool center)
     {
-        addText(text, x, y, 0.0f, scale, color);
+        addText(text, x, y, 0.0f, scale, color, center);
     }
 
-    void FontRenderer::addText(const std::wstring &text, float x, float y, float z, float scale, const glm::vec4 &color, bool center)
+    void FontRenderer::addText(std::string_view text, float x, float y, float z, float scale, const glm::vec4 &color, bool center)
     {
-        if (m_useBillboard)
-            return;
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        if (center)
-        {
-            float textWidth = 0.0f;
-            for (wchar_t c : text)
-            {
-                if (m_characters.contains(c))
-                {
-                    textWidth += (m_characters[c].advance) * scale;
-                }
-            }
-            x -= textWidth / 2.0f;
-        }
-        for (wchar_t c : text)
-        {
-            if (!m_characters.contains(c))
-            {
-                if (FT_Load_Char(m_face, c, FT_LOAD_RENDER))
-                    continue;
-                
-                if (!m_textureAtlas.has(c)) {
-                    if (!setupGlyph(c, m_face->glyph))
-                        continue;
-                    m_characters[c] = {
-                        glm::ivec2(m_face->glyph->bitmap.width, m_face->glyph->bitmap.rows),
-                        glm::ivec2(m_face->glyph->bitmap_left, m_face->glyph->bitmap_top),
-                        static_cast<unsigned int>(m_face->glyph->advance.x >> 6)
-                    };
-                }
-            }
+        appendText(text, glm::vec3(x, y, z), nullptr, scale, color, center);
+    }
 
-            Character& ch = m_characters[c];
+    void FontRenderer::addText(std::string_view text, const glm::vec3 &pos, float scale, const glm::vec4 &color, bool center)
+    {
+        appendText(text, pos, nullptr, scale, color, center);
+    }
 
-            if (!m_textureAtlas.has(c)) { // for cases where the character is not renderable (e.g. space)
-                x += ch.advance * scale;
-                continue;
-            }
+    void FontRenderer::addText(std::wstring_view text, float x, float y, float scale, const glm::vec4 &color, bool center)
+    {
+        addText(text, x, y, 0.0f, scale, color, center);
+    }
 
-            auto [uvMin, uvMax] = m_textureAtlas.get(c);
+    void FontRenderer::addText(std::wstring_view text, float x, float y, float z, float scale, const glm::vec4 &color, bool center)
+    {
+        appendText(text, glm::vec3(x, y, z), nullptr, scale, color, center);
+    }
 
-            float xPos = x + (ch.bearing.x * scale);
-            float yPos = y - (ch.size.y - ch.bearing.y) * scale;
+    void FontRenderer::addText(std::wstring_view text, const glm::vec3 &pos, float scale, const glm::vec4 &color, bool center)
+    {
+        appendText(text, pos, nullptr, scale, color, center);
+    }
 
-            float w = ch.size.x * scale;
-            float h = ch.size.y * scale;
+    void FontRenderer::addText(std::u32string_view text, float x, float y, float scale, const glm::vec4 &color, bool center)
+    {
+        addText(text, x, y, 0.0f, scale, color, center);
+    }
 
-            if (m_curVertex + 4 >= m_vertices.size())
-                m_vertices.resize(m_curVertex + 4);
-            if (m_curIndex + 6 >= m_indices.size())
-                m_indices.resize(m_curIndex + 6);
-            
-            m_vertices[m_curVertex + 0] = { glm::vec3(xPos, yPos + h, z), color, uvMin };
-            m_vertices[m_curVertex + 1] = { glm::vec3(xPos, yPos, z), color, glm::vec2(uvMin.x, uvMax.y) };
-            m_vertices[m_curVertex + 2] = { glm::vec3(xPos + w, yPos, z), color, uvMax };
-            m_vertices[m_curVertex + 3] = { glm::vec3(xPos + w, yPos + h, z), color, glm::vec2(uvMax.x, uvMin.y) };
-
-            m_indices[m_curIndex + 0] = m_curVertex + 0;
-            m_indices[m_curIndex + 1] = m_curVertex + 1;
-            m_indices[m_curIndex + 2] = m_curVertex + 2;
-            m_indices[m_curIndex + 3] = m_curVertex + 0;
-            m_indices[m_curIndex + 4] = m_curVertex + 2;
-            m_indices[m_curIndex + 5] = m_curVertex + 3;
-
-            m_curVertex += 4;
-            m_curIndex += 6;
-
-            x += ch.advance * scale;
-        }
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    void FontRenderer::addText(std::u32string_view text, float x, float y, float z, float scale, const glm::vec4 &color, bool center)
+    {
+        appendText(text, glm::vec3(x, y, z), nullptr, scale, color, center);
     }
 
-    void FontRenderer::addText(const std::wstring &text, const glm::vec3 &pos, float scale, const glm::vec4 &color, bool center)
+    void FontRenderer::addText(std::u32string_view text, const glm::vec3 &pos, float scale, const glm::vec4 &color, bool center)
     {
-        addText(text, pos.x, pos.y, pos.z, scale, color, center);
+        appendText(text, pos, nullptr, scale, color, center);
     }
 
-    void FontRenderer::addText(const std::string &text, float x, float y, float scale, const glm::vec4 &color, bool center)
+    void FontRenderer::addTextBB(std::string_view text, const glm::vec3& pos, const glm::vec3& center, float scale, const glm::vec4& color, bool textCentered)
     {
-        std::wstring wText(text.begin(), text.end());
-        addText(wText, x, y, scale, color, center);
+        appendText(text, pos, &center, scale, color, textCentered);
     }
 
-    void FontRenderer::addText(const std::string &text, float x, float y, float z, float scale, const glm::vec4 &color, bool center)
+    void FontRenderer::addTextBB(std::wstring_view text, const glm::vec3& pos, const glm::vec3& center, float scale, const glm::vec4& color, bool textCentered)
     {
-        std::wstring wText(text.begin(), text.end());
-        addText(wText, x, y, z, scale, color, center);
+        appendText(text, pos, &center, scale, color, textCentered);
     }
 
-    void FontRenderer::addText(const std::string &text, const glm::vec3 &pos, float scale, const glm::vec4 &color, bool center)
+    void FontRenderer::addTextBB(std::u32string_view text, const glm::vec3& pos, const glm::vec3& center, float scale, const glm::vec4& color, bool textCentered)
     {
-        std::wstring wText(text.begin(), text.end());
-        addText(wText, pos.x, pos.y, pos.z, scale, color, center);
+        appendText(text, pos, &center, scale, color, textCentered);
     }
 
-    void FontRenderer::addTextBB(const std::wstring& text, const glm::vec3& pos, const glm::vec3& center, float scale, const glm::vec4& color, bool textCentered)
+    template<typename CharT>
+    void FontRenderer::appendText(std::basic_string_view<CharT> text, const glm::vec3& pos, const glm::vec3* center, float scale, const glm::vec4& color, bool textCentered)
     {
-        if (!m_useBillboard)
+        // billboarded text needs a center and flat text must not have one
+        if (m_useBillboard != (center != nullptr))
             return;
+
+        // narrow chars go through unsigned char so bytes above 127 map to Latin-1 instead of sign extending
+        auto toCodePoint = [](CharT c) {
+            if constexpr (std::is_same_v<CharT, char>)
+                return static_cast<char32_t>(static_cast<unsigned char>(c));
+            else
+                return static_cast<char32_t>(c);
+        };
+
         float x = pos.x;
-        float y = pos.y;
-        float z = pos.z;
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         if (textCentered)
         {
             float textWidth = 0.0f;
-            for (wchar_t c : text)
+            for (CharT c : text)
             {
-                if (m_characters.contains(c))
-                {
-                    textWidth += (m_characters[c].advance) * scale;
-                }
+                if (const GlyphInfo* glyph = getGlyph(toCodePoint(c)))
+                    textWidth += glyph->advance * scale;
             }
             x -= textWidth / 2.0f;
         }
-        for (wchar_t c : text)
-        {
-            if (!m_characters.contains(c))
-            {
-                if (FT_Load_Char(m_face, c, FT_LOAD_RENDER))
-                    continue;
-                
-                if (!m_textureAtlas.has(c)) {
-                    if (!setupGlyph(c, m_face->glyph))
-                        continue;
-                    m_characters[c] = {
-                        glm::ivec2(m_face->glyph->bitmap.width, m_face->glyph->bitmap.rows),
-                        glm::ivec2(m_face->glyph->bitmap_left, m_face->glyph->bitmap_top),
-                        static_cast<unsigned int>(m_face->glyph->advance.x >> 6)
-                    };
-                }
-            }
 
-            Character& ch = m_characters[c];
-
-            if (!m_textureAtlas.has(c)) { // for cases where the character is not renderable (e.g. space)
-                x += ch.advance * scale;
+        for (CharT c : text)
+        {
+            const GlyphInfo* glyph = getGlyph(toCodePoint(c));
+            if (!glyph)
+                continue;
+            if (!glyph->hasBitmap) { // for cases where the character is not renderable (e.g. space)
+                x += glyph->advance * scale;
                 continue;
             }
 
-            auto [uvMin, uvMax] = m_textureAtlas.get(c);
+            // looked up after getGlyph, which may have expanded the atlas
+            glm::vec2 invAtlasSize = 1.0f / glm::vec2(m_textureAtlas.getWidth(), m_textureAtlas.getHeight());
+            glm::vec2 uvMin = glyph->texelMin * invAtlasSize;
+            glm::vec2 uvMax = glyph->texelMax * invAtlasSize;
 
-            float xPos = x + (ch.bearing.x * scale);
-            float yPos = y - (ch.size.y - ch.bearing.y) * scale;
+            float xPos = x + (glyph->bearing.x * scale);
+            float yPos = pos.y - (glyph->size.y - glyph->bearing.y) * scale;
 
-            float w = ch.size.x * scale;
-            float h = ch.size.y * scale;
+            float w = glyph->size.x * scale;
+            float h = glyph->size.y * scale;
 
-            if (m_curVertex + 4 >= m_verticesBB.size())
-                m_verticesBB.resize(m_curVertex + 4);
-            if (m_curIndex + 6 >= m_indices.size())
-                m_indices.resize(m_curIndex + 6);
-            
-            m_verticesBB[m_curVertex + 0] = { glm::vec3(xPos, yPos + h, z), center, color, uvMin };
-            m_verticesBB[m_curVertex + 1] = { glm::vec3(xPos, yPos, z), center, color, glm::vec2(uvMin.x, uvMax.y) };
-            m_verticesBB[m_curVertex + 2] = { glm::vec3(xPos + w, yPos, z), center, color, uvMax };
-            m_verticesBB[m_curVertex + 3] = { glm::vec3(xPos + w, yPos + h, z), center, color, glm::vec2(uvMax.x, uvMin.y) };
-
-            m_indices[m_curIndex + 0] = m_curVertex + 0;
-            m_indices[m_curIndex + 1] = m_curVertex + 1;
-            m_indices[m_curIndex + 2] = m_curVertex + 2;
-            m_indices[m_curIndex + 3] = m_curVertex + 0;
-            m_indices[m_curIndex + 4] = m_curVertex + 2;
-            m_indices[m_curIndex + 5] = m_curVertex + 3;
-
-            m_curVertex += 4;
-            m_curIndex += 6;
-
-            x += ch.advance * scale;
-        }
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-    }
+            if (center)
+            {
+                m_verticesBB.push_back({ glm::vec3(xPos, yPos + h, pos.z), *center, color, uvMin });
+                m_verticesBB.push_back({ glm::vec3(xPos, yPos, pos.z), *center, color, glm::vec2(uvMin.x, uvMax.y) });
+                m_verticesBB.push_back({ glm::vec3(xPos + w, yPos, pos.z), *center, color, uvMax });
+                m_verticesBB.push_back({ glm::vec3(xPos + w, yPos + h, pos.z), *center, color, glm::vec2(uvMax.x, uvMin.y) });
+            }
+            else
+            {
+                m_vertices.push_back({ glm::vec3(xPos, yPos + h, pos.z), color, uvMin });
+                m_vertices.push_back({ glm::vec3(xPos, yPos, pos.z), color, glm::vec2(uvMin.x, uvMax.y) });
+                m_vertices.push_back({ glm::vec3(xPos + w, yPos, pos.z), color, uvMax });
+                m_vertices.push_back({ glm::vec3(xPos + w, yPos + h, pos.z), color, glm::vec2(uvMax.x, uvMin.y) });
+            }
+            ++m_glyphCount;
 
-    void FontRenderer::addTextBB(const std::string& text, const glm::vec3& pos, const glm::vec3& center, float scale, const glm::vec4& color, bool textCentered)
-    {
-        std::wstring wText(text.begin(), text.end());
-        addTextBB(wText, pos, center, scale, color, textCentered);
+            x += glyph->advance * scale;
+        }
     }
 
     void FontRenderer::clearText()
     {
         m_vertices.clear();
         m_verticesBB.clear();
-        m_indices.clear();
-        m_curVertex = 0;
-        m_curIndex = 0;
+        m_glyphCount = 0;
     }
 
     void FontRenderer::draw(bool bindVAO)
     {
-        if (m_curVertex == 0 || m_curIndex == 0)
+        if (m_glyphCount == 0)
             return;
 
         m_textureAtlas.use();
 
-        float* verticesFloats;
-        size_t verticesSize;
-        if (m_useBillboard) {
-            verticesFloats = reinterpret_cast<float*>(m_verticesBB.data());
-            verticesSize = m_curVertex * sizeof(VertexBB) / sizeof(float);
-        } else {
-            verticesFloats = reinterpret_cast<float*>(m_vertices.data());
-            verticesSize = m_curVertex * sizeof(Vertex) / sizeof(float);
-        }
-        auto verticesVec = std::vector<float>(verticesFloats, verticesFloats + verticesSize);
-        m_batchMesh.updateVertexBuffer(verticesVec, verticesSize, bindVAO);
-        m_batchMesh.updateIndexBuffer(m_indices, m_curIndex, false);
-        m_batchMesh.draw(m_curIndex);
+        ensureQuadIndices();
+        bool written = m_useBillboard
+            ? m_stream.write(m_verticesBB.data(), m_verticesBB.size())
+            : m_stream.write(m_vertices.data(), m_vertices.size());
+        if (written)
+            m_stream.draw(static_cast<int>(m_glyphCount * 6), bindVAO);
     }
 
     void FontRenderer::initFTLib()
@@ -373,15 +335,105 @@ namespace gfx
         m_fontSize = fontSize;
     }
 
-    bool FontRenderer::setupGlyph(wchar_t character, FT_GlyphSlot glyph)
+    Glyph FontRenderer::makeGlyph(char32_t character, FT_GlyphSlot slot)
     {
-        unsigned int width = glyph->bitmap.width;
-        unsigned int height = glyph->bitmap.rows;
-        
-        if (glyph->bitmap.buffer != nullptr) {
-            auto uvs = m_textureAtlas.add(character, glyph->bitmap.buffer, width, height);
-            return uvs.first != glm::vec2(0) && uvs.second != glm::vec2(0);
+        Glyph glyph;
+        glyph.character = static_cast<wchar_t>(character);
+        glyph.size = glm::ivec2(slot->bitmap.width, slot->bitmap.rows);
+        glyph.bearing = glm::ivec2(slot->bitmap_left, slot->bitmap_top);
+        glyph.advance = static_cast<unsigned int>(slot->advance.x >> 6);
+        if (slot->bitmap.buffer != nullptr)
+        {
+            // rows of the FreeType bitmap may be padded, the copy is tightly packed
+            glyph.bitmap.resize(static_cast<size_t>(glyph.size.x) * glyph.size.y);
+            for (int row = 0; row < glyph.size.y; ++row)
+                std::copy_n(slot->bitmap.buffer + row * slot->bitmap.pitch, glyph.size.x, glyph.bitmap.data() + row * glyph.size.x);
         }
-        return true;  // for cases where the character is not renderable (e.g. space)
+        return glyph;
+    }
+
+    const FontRenderer::GlyphInfo* FontRenderer::findGlyph(char32_t character) const
+    {
+        if (character < DIRECT_GLYPHS)
+        {
+            const GlyphInfo& glyph = m_directGlyphs[character];
+            return glyph.loaded ? &glyph : nullptr;
+        }
+        auto it = m_overflowGlyphs.find(character);
+        return it != m_overflowGlyphs.end() ? &it->second : nullptr;
+    }
+
+    const FontRenderer::GlyphInfo* FontRenderer::getGlyph(char32_t character)
+    {
+        if (const GlyphInfo* glyph = findGlyph(character))
+            return glyph;
+        if (!m_face || FT_Load_Char(m_face, character, FT_LOAD_RENDER))
+            return nullptr;
+
+        // the unpack alignment is only touched on a miss, so cached text never changes GL state
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        bool added = addGlyph(makeGlyph(character, m_face->glyph));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        return added ? findGlyph(character) : nullptr;
+    }
+
+    bool FontRenderer::addGlyph(const Glyph& glyph)
+    {
+        char32_t character = static_cast<char32_t>(glyph.character);
+        if (findGlyph(character))
+            return true;
+
+        GlyphInfo info;
+        info.size = glyph.size;
+        info.bearing = glyph.bearing;
+        info.advance = static_cast<float>(glyph.advance);
+        info.loaded = true;
+        if (!glyph.bitmap.empty())
+        {
+            glm::vec2 oldAtlasSize(m_textureAtlas.getWidth(), m_textureAtlas.getHeight());
+            auto [uvMin, uvMax] = m_textureAtlas.add(glyph.character, glyph.bitmap.data(), glyph.size.x, glyph.size.y);
+            if (uvMax == glm::vec2(0))
+                return false;
+            glm::vec2 atlasSize(m_textureAtlas.getWidth(), m_textureAtlas.getHeight());
+            if (oldAtlasSize != atlasSize && oldAtlasSize.x > 0 && oldAtlasSize.y > 0)
+                rescaleBatchTexCoords(oldAtlasSize / atlasSize);
+            info.texelMin = uvMin * atlasSize;
+            info.texelMax = uvMax * atlasSize;
+            info.hasBitmap = true;
+        }
+
+        if (character < DIRECT_GLYPHS)
+            m_directGlyphs[character] = info;
+        else
+            m_overflowGlyphs[character] = info;
+        return true;
+    }
+
+    void FontRenderer::ensureQuadIndices()
+    {
+        if (m_glyphCount <= m_quadIndexCapacity)
+            return;
+        // every quad uses the same pattern, so the buffer only has to be rewritten when it grows
+        m_quadIndexCapacity = std::max(m_glyphCount, m_quadIndexCapacity * 2);
+        std::vector<unsigned int> indices(m_quadIndexCapacity * 6);
+        for (size_t i = 0; i < m_quadIndexCapacity; ++i)
+        {
+            unsigned int vertex = static_cast<unsigned int>(i * 4);
+            indices[i * 6 + 0] = vertex + 0;
+            indices[i * 6 + 1] = vertex + 1;
+            indices[i * 6 + 2] = vertex + 2;
+            indices[i * 6 + 3] = vertex + 0;
+            indices[i * 6 + 4] = vertex + 2;
+            indices[i * 6 + 5] = vertex + 3;
+        }
+        m_stream.setIndices(indices);
+    }
+
+    void FontRenderer::rescaleBatchTexCoords(const glm::vec2& scale)
+    {
+        for (Vertex& vertex : m_vertices)
+            vertex.texCoords *= scale;
+        for (VertexBB& vertex : m_verticesBB)
+            vertex.texCoords *= scale;
     }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "graphics/gfx/line_renderer.h"
 
 #include <glad/glad.h>
+#include <algorithm>
 
 namespace gfx
 {
@@ -17,13 +18,12 @@ namespace gfx
         if (this != &other)
         {
             m_vertices = std::move(other.m_vertices);
-            m_indices = std::move(other.m_indices);
             m_curVertex = other.m_curVertex;
-            m_curIndex = other.m_curIndex;
+            m_lineIndexCapacity = other.m_lineIndexCapacity;
             m_meshInitialized = other.m_meshInitialized;
-            m_mesh = std::move(other.m_mesh);
+            m_stream = std::move(other.m_stream);
             other.m_curVertex = 0;
-            other.m_curIndex = 0;
+            other.m_lineIndexCapacity = 0;
             other.m_meshInitialized = false;
         }
         return *this;
@@ -31,14 +31,13 @@ namespace gfx
 
     LineRenderer::LineRenderer(LineRenderer&& other) noexcept
         : m_vertices(std::move(other.m_vertices)),
-          m_indices(std::move(other.m_indices)),
           m_curVertex(other.m_curVertex),
-          m_curIndex(other.m_curIndex),
-          m_meshInitialized(other.m_meshInitialized),
-          m_mesh(std::move(other.m_mesh))
+          m_lineIndexCapacity(other.m_lineIndexCapacity),
+          m_stream(std::move(other.m_stream)),
+          m_meshInitialized(other.m_meshInitialized)
     {
         other.m_curVertex = 0;
-        other.m_curIndex = 0;
+        other.m_lineIndexCapacity = 0;
         other.m_meshInitialized = false;
     }
 
@@ -46,34 +45,24 @@ namespace gfx
     {
         if (!m_meshInitialized)
         {
-            m_mesh.populate({}, {}, {3, 3, 4}, GL_DYNAMIC_DRAW, GL_DYNAMIC_DRAW);
+            m_stream.setup({3, 3, 4});
             m_meshInitialized = true;
+            m_lineIndexCapacity = 0;
         }
         m_curVertex = 0;
-        m_curIndex = 0;
     }
 
     void LineRenderer::drawLine(const glm::vec3& start, const glm::vec3& end, const glm::vec4& color)
     {
         if (m_curVertex + 4 >= m_vertices.size())
             m_vertices.resize(m_curVertex + 4);
-        if (m_curIndex + 6 >= m_indices.size())
-            m_indices.resize(m_curIndex + 6);
 
         m_vertices[m_curVertex + 0] = { start, end - start, color };
         m_vertices[m_curVertex + 1] = { end, start - end, color };
         m_vertices[m_curVertex + 2] = { end, start - end, color };
         m_vertices[m_curVertex + 3] = { start, end - start, color };
 
-        m_indices[m_curIndex + 0] = m_curVertex + 0;
-        m_indices[m_curIndex + 1] = m_curVertex + 1;
-        m_indices[m_curIndex + 2] = m_curVertex + 2;
-        m_indices[m_curIndex + 3] = m_curVertex + 0;
-        m_indices[m_curIndex + 4] = m_curVertex + 3;
-        m_indices[m_curIndex + 5] = m_curVertex + 1;
-
         m_curVertex += 4;
-        m_curIndex += 6;
     }
 
     void LineRenderer::drawCube(const glm::vec3& position, const glm::vec3& size, const glm::vec4& color)
@@ -138,13 +127,30 @@ namespace gfx
         if (m_curVertex == 0)
             return;
 
-        float* verticesFloats = reinterpret_cast<float*>(m_vertices.data());
-        size_t verticesSize = m_curVertex * sizeof(Vertex) / sizeof(float);
-        auto verticesVec = std::vector<float>(verticesFloats, verticesFloats + verticesSize);
-        m_mesh.updateVertexBuffer(verticesVec, verticesSize, bindVAO);
-        m_mesh.updateIndexBuffer(m_indices, m_curIndex, false);
-        m_mesh.draw(m_curIndex);
+        size_t lineCount = m_curVertex / 4;
+        ensureLineIndices(lineCount);
+        if (!m_stream.write(m_vertices.data(), m_curVertex))
+            return;
+        m_stream.draw(static_cast<int>(lineCount * 6), bindVAO);
     }
 
+    void LineRenderer::ensureLineIndices(size_t lineCount)
+    {
+        if (lineCount <= m_lineIndexCapacity)
+            return;
+        m_lineIndexCapacity = std::max(lineCount, m_lineIndexCapacity * 2);
+        std::vector<unsigned int> indices(m_lineIndexCapacity * 6);
+        for (size_t i = 0; i < m_lineIndexCapacity; ++i)
+        {
+            unsigned int vertex = static_cast<unsigned int>(i * 4);
+            indices[i * 6 + 0] = vertex + 0;
+            indices[i * 6 + 1] = vertex + 1;
+            indices[i * 6 + 2] = vertex + 2;
+            indices[i * 6 + 3] = vertex + 0;
+            indices[i * 6 + 4] = vertex + 3;
+            indices[i * 6 + 5] = vertex + 1;
+        }
+        m_stream.setIndices(indices);
+    }
 
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "graphics/gfx/mesh.h"
 #include <numeric>
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
 namespace gfx
@@ -15,8 +16,9 @@ namespace gfx
         m_vao = other.m_vao;
         m_vbo = other.m_vbo;
         m_ebo = other.m_ebo;
-        m_vertices = std::move(other.m_vertices);
-        m_indices = std::move(other.m_indices);
+        m_vertexBufferSize = other.m_vertexBufferSize;
+        m_indexBufferSize = other.m_indexBufferSize;
+        m_indexCount = other.m_indexCount;
         m_vboHint = other.m_vboHint;
         m_eboHint = other.m_eboHint;
         
@@ -33,8 +35,9 @@ namespace gfx
             m_vao = other.m_vao;
             m_vbo = other.m_vbo;
             m_ebo = other.m_ebo;
-            m_vertices = std::move(other.m_vertices);
-            m_indices = std::move(other.m_indices);
+            m_vertexBufferSize = other.m_vertexBufferSize;
+            m_indexBufferSize = other.m_indexBufferSize;
+            m_indexCount = other.m_indexCount;
             m_vboHint = other.m_vboHint;
             m_eboHint = other.m_eboHint;
 
@@ -90,8 +93,9 @@ namespace gfx
             eboHint
         );
 
-        m_indices = indices;
-        m_vertices = vertices;
+        m_vertexBufferSize = vertices.size();
+        m_indexBufferSize = indices.size();
+        m_indexCount = indices.size();
         m_vboHint = vboHint;
         m_eboHint = eboHint;
     }
@@ -101,26 +105,27 @@ namespace gfx
         if (bindVAO)
             glBindVertexArray(m_vao);
         glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        if (vertCount > this->m_vertices.size())
+        // only the first vertCount floats are uploaded
+        size_t floatCount = std::min<size_t>(vertCount, vertices.size());
+        if (floatCount > m_vertexBufferSize)
         {
             glBufferData(
                 GL_ARRAY_BUFFER, 
-                vertices.size() * sizeof(GL_FLOAT), 
+                floatCount * sizeof(GL_FLOAT), 
                 vertices.data(), 
                 m_vboHint
             );
+            m_vertexBufferSize = floatCount;
         }
         else
         {
             glBufferSubData(
                 GL_ARRAY_BUFFER, 
                 0, 
-                vertices.size() * sizeof(GL_FLOAT), 
+                floatCount * sizeof(GL_FLOAT), 
                 vertices.data()
             );
         }
-
-        this->m_vertices = vertices;
     }
 
     void Mesh::updateIndexBuffer(const std::vector<unsigned int> &indices, unsigned int indexCount, bool bindVAO)
@@ -128,7 +133,7 @@ namespace gfx
         if (bindVAO)
             glBindVertexArray(m_vao);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-        if (indexCount > this->m_indices.size())
+        if (indices.size() > m_indexBufferSize)
         {
             glBufferData(
                 GL_ELEMENT_ARRAY_BUFFER, 
@@ -136,6 +141,7 @@ namespace gfx
                 indices.data(), 
                 m_eboHint
             );
+            m_indexBufferSize = indices.size();
         }
         else
         {
@@ -147,7 +153,7 @@ namespace gfx
             );
         }
 
-        this->m_indices = indices;
+        m_indexCount = indexCount;
     }
 
     void Mesh::updateBuffers(
@@ -174,7 +180,7 @@ namespace gfx
 
     void Mesh::draw() const
     {
-        draw(m_indices.size());
+        draw(m_indexCount);
     }
 
     void Mesh::draw(int indexCount) const
@@ -200,5 +206,8 @@ namespace gfx
         m_vao = 0;
         m_vbo = 0;
         m_ebo = 0;
+        m_vertexBufferSize = 0;
+        m_indexBufferSize = 0;
+        m_indexCount = 0;
     }
 }
\ No newline at end of file
@@ -1,11 +1,32 @@
 #include "graphics/gfx/shader.h"
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <filesystem>
 #include <spdlog/spdlog.h>
 #include <glad/glad.h>
+#include "utils/algorithms.h"
 
 namespace gfx
 {
+    namespace
+    {
+        const char PROGRAM_BINARY_MAGIC[4] = {'V', 'X', 'S', 'B'};
+
+        struct ProgramBinaryHeader
+        {
+            char magic[4];
+            uint32_t format;
+            uint64_t key;
+            uint64_t length;
+        };
+    }
+
+    std::string Shader::s_binaryCacheDir;
+
     std::string readFile(const std::string& path)
     {
         std::string result;
@@ -58,17 +79,48 @@ namespace gfx
 
     void Shader::loadFromFile(const std::string& vertPath, const std::string& fragPath, const std::string& geomPath)
     {
-        std::string vertString = readFile(vertPath);
-        const char* vShaderCode = vertString.c_str();
-        std::string fragString = readFile(fragPath);
-        const char* fShaderCode = fragString.c_str();
-        std::string geomString;
-        const char* gShaderCode;
-        if (!geomPath.empty()) {
-            geomString = readFile(vertPath);
-            gShaderCode = geomString.c_str();
+        loadFromSource(readSources(vertPath, fragPath, geomPath));
+    }
+
+    ShaderSources Shader::readSources(const std::string& vertPath, const std::string& fragPath, const std::string& geomPath)
+    {
+        ShaderSources sources;
+        sources.vertex = readFile(vertPath);
+        sources.fragment = readFile(fragPath);
+        if (!geomPath.empty())
+            sources.geometry = readFile(geomPath);
+        return sources;
+    }
+
+    void Shader::setBinaryCacheDir(const std::string& dir)
+    {
+        s_binaryCacheDir = dir;
+        if (dir.empty())
+            return;
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec)
+        {
+            spdlog::warn("Shader: Failed to create program binary cache {}: {}", dir, ec.message());
+            s_binaryCacheDir.clear();
+        }
+    }
+
+    void Shader::loadFromSource(const ShaderSources& sources)
+    {
+        bool useBinaryCache = !s_binaryCacheDir.empty() && supportsProgramBinary();
+        uint64_t binaryKey = useBinaryCache ? getBinaryKey(sources) : 0;
+        if (useBinaryCache && loadBinary(binaryKey))
+        {
+            cacheUniformLocations();
+            return;
         }
 
+        const char* vShaderCode = sources.vertex.c_str();
+        const char* fShaderCode = sources.fragment.c_str();
+        bool hasGeometry = !sources.geometry.empty();
+        const char* gShaderCode = sources.geometry.c_str();
+
         GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
         glShaderSource(vertexShader, 1, &vShaderCode, NULL);
         compileShader(vertexShader);
@@ -76,7 +128,7 @@ namespace gfx
         glShaderSource(fragmentShader, 1, &fShaderCode, NULL);
         compileShader(fragmentShader);
         GLuint geometryShader;
-        if (!geomPath.empty()) {
+        if (hasGeometry) {
             geometryShader = glCreateShader(GL_GEOMETRY_SHADER);
             glShaderSource(geometryShader, 1, &gShaderCode, NULL);
             compileShader(geometryShader);
@@ -85,21 +137,142 @@ namespace gfx
         m_id = glCreateProgram();
         glAttachShader(m_id, vertexShader);
         glAttachShader(m_id, fragmentShader);
-        if (!geomPath.empty())
+        if (hasGeometry)
             glAttachShader(m_id, geometryShader);
-        linkProgram(m_id);
+#ifdef GL_VERSION_4_1
+        if (useBinaryCache)
+            glProgramParameteri(m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+        bool linked = linkProgram(m_id);
 
         glDetachShader(m_id, vertexShader);
         glDetachShader(m_id, fragmentShader);
-        if (!geomPath.empty())
+        if (hasGeometry)
             glDetachShader(m_id, geometryShader);
         
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
-        if (!geomPath.empty())
+        if (hasGeometry)
             glDeleteShader(geometryShader);
-        
-        m_uniformLocations = std::unordered_map<std::string, int>();
+
+
+        if (useBinaryCache && linked)
+            saveBinary(binaryKey);
+        cacheUniformLocations();
+    }
+
+    bool Shader::supportsProgramBinary()
+    {
+#ifdef GL_VERSION_4_1
+        if (!GLAD_GL_VERSION_4_1)
+            return false;
+        GLint formatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        return formatCount > 0;
+#else
+        return false;
+#endif
+    }
+
+    uint64_t Shader::getBinaryKey(const ShaderSources& sources)
+    {
+        uint64_t hash = algo::FNV1A_OFFSET;
+        for (const std::string* source : { &sources.vertex, &sources.fragment, &sources.geometry })
+        {
+            // hashing the length as well keeps text moving between stages from giving the same key
+            uint64_t length = source->size();
+            hash = algo::fnv1a(&length, sizeof(length), hash);
+            hash = algo::fnv1a(source->data(), source->size(), hash);
+        }
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const char* str = reinterpret_cast<const char*>(glGetString(name));
+            if (str)
+                hash = algo::fnv1a(str, std::strlen(str), hash);
+        }
+        return hash;
+    }
+
+    std::string Shader::getBinaryPath(uint64_t key)
+    {
+        return fmt::format("{}/{:016x}.bin", s_binaryCacheDir, key);
+    }
+
+    bool Shader::loadBinary(uint64_t key)
+    {
+#ifdef GL_VERSION_4_1
+        std::filesystem::path path = getBinaryPath(key);
+        std::error_code ec;
+        uintmax_t fileSize = std::filesystem::file_size(path, ec);
+        if (ec || fileSize < sizeof(ProgramBinaryHeader))
+            return false;
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        ProgramBinaryHeader header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || std::memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(PROGRAM_BINARY_MAGIC)) != 0 || header.key != key)
+            return false;
+        // a truncated or corrupt file must not decide how much gets allocated
+        if (header.length == 0 || header.length != fileSize - sizeof(header)
+            || header.length > static_cast<uint64_t>(std::numeric_limits<GLsizei>::max()))
+        {
+            spdlog::info("Shader: Cached program binary {:016x} has a bad length, compiling from source.", key);
+            return false;
+        }
+        std::vector<char> binary(header.length);
+        file.read(binary.data(), binary.size());
+        if (!file)
+            return false;
+
+        m_id = glCreateProgram();
+        glProgramBinary(m_id, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+        int success;
+        glGetProgramiv(m_id, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            // drivers may reject binaries from an older build even when the version string matches
+            spdlog::info("Shader: Cached program binary {:016x} was rejected, compiling from source.", key);
+            glDeleteProgram(m_id);
+            m_id = 0;
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void Shader::saveBinary(uint64_t key) const
+    {
+#ifdef GL_VERSION_4_1
+        GLint length = 0;
+        glGetProgramiv(m_id, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(m_id, length, nullptr, &format, binary.data());
+
+        ProgramBinaryHeader header{};
+        std::memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(PROGRAM_BINARY_MAGIC));
+        header.format = format;
+        header.key = key;
+        header.length = binary.size();
+
+        std::string path = getBinaryPath(key);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), binary.size());
+        if (!file)
+            spdlog::warn("Shader: Failed to write program binary {}.", path);
+#endif
+    }
+
+    void Shader::cacheUniformLocations()
+    {
+        m_uniformLocations.clear();
         int numUniforms;
         glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &numUniforms);
         for (int i = 0; i < numUniforms; i++)
@@ -108,8 +281,16 @@ namespace gfx
             int length, size;
             GLenum type;
             glGetActiveUniform(m_id, i, 256, &length, &size, &type, name);
-            m_uniformLocations[std::string(name)] = glGetUniformLocation(m_id, name);
+            int location = glGetUniformLocation(m_id, name);
+            std::string_view uniformName(name, length);
+            m_uniformLocations.push_back({std::string(uniformName), location});
+            // active uniform arrays are reported with the first element's subscript
+            if (uniformName.ends_with("[0]"))
+                m_uniformLocations.push_back({std::string(uniformName.substr(0, uniformName.size() - 3)), location});
         }
+        std::sort(m_uniformLocations.begin(), m_uniformLocations.end(), [](const UniformLocation& a, const UniformLocation& b) {
+            return a.name < b.name;
+        });
     }
 
     void Shader::use()
@@ -139,58 +320,140 @@ namespace gfx
         return glGetAttribLocation(m_id, name);
     }
 
+    int Shader::getUniformLocation(std::string_view name) const
+    {
+        auto it = std::lower_bound(m_uniformLocations.begin(), m_uniformLocations.end(), name, [](const UniformLocation& uniform, std::string_view name) {
+            return uniform.name < name;
+        });
+        return it == m_uniformLocations.end() || it->name != name ? -1 : it->location;
+    }
+
+    void Shader::bindUniformBlock(const char *blockName, unsigned int binding)
+    {
+        unsigned int blockIndex = glGetUniformBlockIndex(m_id, blockName);
+        if (blockIndex != GL_INVALID_INDEX)
+            glUniformBlockBinding(m_id, blockIndex, binding);
+    }
+
     void Shader::setBool(const char *name, bool value)
     {
-        glUseProgram(m_id);
-        glUniform1i(m_uniformLocations[name], (int)value);
+        setBool(getUniformLocation(name), value);
     }
 
     void Shader::setInt(const char *name, int value)
     {
-        glUseProgram(m_id);
-        glUniform1i(m_uniformLocations[name], value);
+        setInt(getUniformLocation(name), value);
     }
 
     void Shader::setFloat(const char *name, float value)
     {
-        glUseProgram(m_id);
-        glUniform1f(m_uniformLocations[name], value);
+        setFloat(getUniformLocation(name), value);
     }
 
     void Shader::setVec2(const char *name, const glm::vec2 &value)
     {
-        glUseProgram(m_id);
-        glUniform2fv(m_uniformLocations[name], 1, &value[0]);
+        setVec2(getUniformLocation(name), value);
     }
 
     void Shader::setVec3(const char *name, const glm::vec3 &value)
     {
-        glUseProgram(m_id);
-        glUniform3fv(m_uniformLocations[name], 1, &value[0]);
+        setVec3(getUniformLocation(name), value);
     }
 
     void Shader::setVec4(const char *name, const glm::vec4 &value)
     {
-        glUseProgram(m_id);
-        glUniform4fv(m_uniformLocations[name], 1, &value[0]);
+        setVec4(getUniformLocation(name), value);
+    }
+
+    void Shader::setIntArray(const char *name, const int *values, int count)
+    {
+        setIntArray(getUniformLocation(name), values, count);
+    }
+
+    void Shader::setVec4Array(const char *name, const glm::vec4 *values, int count)
+    {
+        setVec4Array(getUniformLocation(name), values, count);
     }
 
     void Shader::setMat2(const char *name, const glm::mat2 &value)
     {
-        glUseProgram(m_id);
-        glUniformMatrix2fv(m_uniformLocations[name], 1, GL_FALSE, &value[0][0]);
+        setMat2(getUniformLocation(name), value);
     }
 
     void Shader::setMat3(const char *name, const glm::mat3 &value)
     {
-        glUseProgram(m_id);
-        glUniformMatrix3fv(m_uniformLocations[name], 1, GL_FALSE, &value[0][0]);
+        setMat3(getUniformLocation(name), value);
     }
 
     void Shader::setMat4(const char *name, const glm::mat4 &value)
+    {
+        setMat4(getUniformLocation(name), value);
+    }
+
+    void Shader::setBool(int location, bool value)
+    {
+        glUseProgram(m_id);
+        glUniform1i(location, (int)value);
+    }
+
+    void Shader::setInt(int location, int value)
+    {
+        glUseProgram(m_id);
+        glUniform1i(location, value);
+    }
+
+    void Shader::setFloat(int location, float value)
+    {
+        glUseProgram(m_id);
+        glUniform1f(location, value);
+    }
+
+    void Shader::setVec2(int location, const glm::vec2 &value)
+    {
+        glUseProgram(m_id);
+        glUniform2fv(location, 1, &value[0]);
+    }
+
+    void Shader::setVec3(int location, const glm::vec3 &value)
+    {
+        glUseProgram(m_id);
+        glUniform3fv(location, 1, &value[0]);
+    }
+
+    void Shader::setVec4(int location, const glm::vec4 &value)
+    {
+        glUseProgram(m_id);
+        glUniform4fv(location, 1, &value[0]);
+    }
+
+    void Shader::setIntArray(int location, const int *values, int count)
+    {
+        glUseProgram(m_id);
+        glUniform1iv(location, count, values);
+    }
+
+    void Shader::setVec4Array(int location, const glm::vec4 *values, int count)
+    {
+        glUseProgram(m_id);
+        glUniform4fv(location, count, &values[0][0]);
+    }
+
+    void Shader::setMat2(int location, const glm::mat2 &value)
+    {
+        glUseProgram(m_id);
+        glUniformMatrix2fv(location, 1, GL_FALSE, &value[0][0]);
+    }
+
+    void Shader::setMat3(int location, const glm::mat3 &value)
+    {
+        glUseProgram(m_id);
+        glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+    }
+
+    void Shader::setMat4(int location, const glm::mat4 &value)
     {
         glUseProgram(m_id);
-        glUniformMatrix4fv(m_uniformLocations[name], 1, GL_FALSE, &value[0][0]);
+        glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
     }
 
     void Shader::compileShader(int shader)
@@ -206,7 +469,7 @@ namespace gfx
         }
     }
 
-    void Shader::linkProgram(int program)
+    bool Shader::linkProgram(int program)
     {
         glLinkProgram(program);
         int success;
@@ -217,5 +480,6 @@ namespace gfx
             glGetProgramInfoLog(program, 512, NULL, infoLog);
             spdlog::error("ERROR::SHADER::PROGRAM::LINKING_FAILED: {}", infoLog);
         }
+        return success;
     }
 }
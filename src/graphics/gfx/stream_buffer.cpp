@@ -0,0 +1,267 @@
+#include "graphics/gfx/stream_buffer.h"
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace gfx
+{
+    StreamBuffer::~StreamBuffer()
+    {
+        destroy();
+    }
+
+    StreamBuffer::StreamBuffer(StreamBuffer&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    StreamBuffer& StreamBuffer::operator=(StreamBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_vao = other.m_vao;
+            m_vbo = other.m_vbo;
+            m_ebo = other.m_ebo;
+            m_dims = std::move(other.m_dims);
+            m_stride = other.m_stride;
+            m_segmentVertices = other.m_segmentVertices;
+            m_cursor = other.m_cursor;
+            m_segment = other.m_segment;
+            m_baseVertex = other.m_baseVertex;
+            m_persistent = other.m_persistent;
+            m_mapped = other.m_mapped;
+            m_persistentData = other.m_persistentData;
+            m_fences = other.m_fences;
+
+            other.m_vao = 0;
+            other.m_vbo = 0;
+            other.m_ebo = 0;
+            other.m_mapped = false;
+            other.m_persistentData = nullptr;
+            other.m_fences.fill(nullptr);
+        }
+        return *this;
+    }
+
+    void StreamBuffer::setup(const std::vector<unsigned int>& dims, size_t segmentVertices)
+    {
+        destroy();
+        m_dims = dims;
+        m_stride = std::accumulate(dims.begin(), dims.end(), 0u) * sizeof(GL_FLOAT);
+        m_segmentVertices = std::max<size_t>(segmentVertices, 1);
+#ifdef GL_VERSION_4_4
+        m_persistent = GLAD_GL_VERSION_4_4;
+#endif
+
+        glGenVertexArrays(1, &m_vao);
+        glBindVertexArray(m_vao);
+        glGenBuffers(1, &m_ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+        createVertexBuffer();
+        glBindVertexArray(0);
+    }
+
+    void StreamBuffer::setIndices(const std::vector<unsigned int>& indices)
+    {
+        if (m_vao == 0) {
+            spdlog::warn("StreamBuffer: Buffer not initialized.");
+            return;
+        }
+        glBindVertexArray(m_vao);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+    }
+
+    void* StreamBuffer::map(size_t vertexCount)
+    {
+        if (m_vao == 0) {
+            spdlog::warn("StreamBuffer: Buffer not initialized.");
+            return nullptr;
+        }
+        if (m_mapped) {
+            spdlog::warn("StreamBuffer: Buffer is already mapped.");
+            return nullptr;
+        }
+        if (vertexCount == 0)
+            return nullptr;
+
+        if (vertexCount > m_segmentVertices)
+        {
+            // the old storage is released to the driver, which keeps it alive for draws still reading it
+            m_segmentVertices = std::max(vertexCount, m_segmentVertices * 2);
+            destroyVertexBuffer();
+            glBindVertexArray(m_vao);
+            createVertexBuffer();
+            glBindVertexArray(0);
+        }
+        else if (m_cursor + vertexCount > (m_segment + 1) * m_segmentVertices)
+        {
+            nextSegment();
+        }
+
+        m_baseVertex = m_cursor;
+        m_cursor += vertexCount;
+        size_t offset = m_baseVertex * m_stride;
+        if (m_persistent)
+        {
+            m_mapped = true;
+            return m_persistentData + offset;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        void* data = glMapBufferRange(GL_ARRAY_BUFFER, offset, vertexCount * m_stride, 
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!data) {
+            spdlog::warn("StreamBuffer: Failed to map {} vertices.", vertexCount);
+            return nullptr;
+        }
+        m_mapped = true;
+        return data;
+    }
+
+    void StreamBuffer::unmap()
+    {
+        if (!m_mapped)
+            return;
+        m_mapped = false;
+        // persistent storage is coherent, writes are visible without unmapping
+        if (m_persistent)
+            return;
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        if (!glUnmapBuffer(GL_ARRAY_BUFFER))
+            spdlog::warn("StreamBuffer: Buffer contents were lost while mapped.");
+    }
+
+    bool StreamBuffer::write(const void* vertices, size_t vertexCount)
+    {
+        void* data = map(vertexCount);
+        if (!data)
+            return false;
+        std::memcpy(data, vertices, vertexCount * m_stride);
+        unmap();
+        return true;
+    }
+
+    void StreamBuffer::draw(int indexCount, bool bindVAO) const
+    {
+        if (m_vao == 0 || indexCount <= 0)
+            return;
+        if (bindVAO)
+            glBindVertexArray(m_vao);
+        glDrawElementsBaseVertex(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr, static_cast<GLint>(m_baseVertex));
+    }
+
+    void StreamBuffer::destroy()
+    {
+        destroyVertexBuffer();
+        if (m_ebo != 0)
+        {
+            glDeleteBuffers(1, &m_ebo);
+            m_ebo = 0;
+        }
+        if (m_vao != 0)
+        {
+            glDeleteVertexArrays(1, &m_vao);
+            m_vao = 0;
+        }
+    }
+
+    void StreamBuffer::createVertexBuffer()
+    {
+        size_t size = m_segmentVertices * SEGMENTS * m_stride;
+        glGenBuffers(1, &m_vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+#ifdef GL_VERSION_4_4
+        if (m_persistent)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+            m_persistentData = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+            if (!m_persistentData)
+            {
+                spdlog::warn("StreamBuffer: Failed to map persistent storage, falling back to orphaning.");
+                glDeleteBuffers(1, &m_vbo);
+                glGenBuffers(1, &m_vbo);
+                glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+                m_persistent = false;
+            }
+        }
+#endif
+        if (!m_persistent)
+            glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+        size_t offset = 0;
+        for (size_t i = 0; i < m_dims.size(); ++i)
+        {
+            glVertexAttribPointer(i, m_dims[i], GL_FLOAT, GL_FALSE, static_cast<GLsizei>(m_stride), (void*)offset);
+            glEnableVertexAttribArray(i);
+            offset += m_dims[i] * sizeof(GL_FLOAT);
+        }
+        m_cursor = 0;
+        m_segment = 0;
+        m_baseVertex = 0;
+    }
+
+    void StreamBuffer::destroyVertexBuffer()
+    {
+        for (GLsync& fence : m_fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+        if (m_vbo != 0)
+        {
+            // deleting a buffer unmaps it
+            glDeleteBuffers(1, &m_vbo);
+            m_vbo = 0;
+        }
+        m_persistentData = nullptr;
+        m_mapped = false;
+    }
+
+    void StreamBuffer::nextSegment()
+    {
+        if (m_persistent)
+        {
+            if (m_fences[m_segment])
+                glDeleteSync(m_fences[m_segment]);
+            m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        m_segment = (m_segment + 1) % SEGMENTS;
+        m_cursor = m_segment * m_segmentVertices;
+        if (m_persistent)
+        {
+            waitFence(m_segment);
+        }
+        else if (m_segment == 0)
+        {
+            // nothing written since the last orphan is still in use, so only the wrap needs new storage
+            glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+            glBufferData(GL_ARRAY_BUFFER, m_segmentVertices * SEGMENTS * m_stride, nullptr, GL_STREAM_DRAW);
+        }
+    }
+
+    void StreamBuffer::waitFence(int segment)
+    {
+        GLsync& fence = m_fences[segment];
+        if (!fence)
+            return;
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            // the GPU is more than SEGMENTS segments behind, so the write has to wait for it
+            const GLuint64 timeout = 100'000'000;
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+        if (result == GL_WAIT_FAILED)
+            spdlog::warn("StreamBuffer: Waiting on a segment fence failed.");
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
@@ -0,0 +1,79 @@
+#include "graphics/gfx/uniform_buffer.h"
+#include <spdlog/spdlog.h>
+
+namespace gfx
+{
+    UniformBuffer::~UniformBuffer()
+    {
+        destroy();
+    }
+
+    UniformBuffer::UniformBuffer(UniformBuffer&& other) noexcept
+    {
+        m_id = other.m_id;
+        m_size = other.m_size;
+        m_binding = other.m_binding;
+        other.m_id = 0;
+        other.m_size = 0;
+    }
+
+    UniformBuffer& UniformBuffer::operator=(UniformBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_id = other.m_id;
+            m_size = other.m_size;
+            m_binding = other.m_binding;
+            other.m_id = 0;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    void UniformBuffer::setup(size_t size, unsigned int binding)
+    {
+        destroy();
+        m_size = size;
+        m_binding = binding;
+        glGenBuffers(1, &m_id);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        bind();
+    }
+
+    void UniformBuffer::update(const void* data, size_t size, size_t offset)
+    {
+        if (m_id == 0) {
+            spdlog::warn("UniformBuffer: Buffer not initialized.");
+            return;
+        }
+        if (offset + size > m_size) {
+            spdlog::warn("UniformBuffer: Update of {} bytes at {} overflows the {} byte buffer.", size, offset, m_size);
+            return;
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+        // a full update orphans the old storage so the driver does not wait on draws still reading it
+        if (offset == 0 && size == m_size)
+            glBufferData(GL_UNIFORM_BUFFER, m_size, data, GL_DYNAMIC_DRAW);
+        else
+            glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void UniformBuffer::bind() const
+    {
+        glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_id);
+    }
+
+    void UniformBuffer::destroy()
+    {
+        if (m_id != 0)
+        {
+            glDeleteBuffers(1, &m_id);
+            m_id = 0;
+            m_size = 0;
+        }
+    }
+}
@@ -0,0 +1,199 @@
+#include "graphics/light_level_renderer.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace
+{
+    const int DIGIT_WIDTH = 3;
+    const int DIGIT_ROWS = 5;
+    // each row of a digit is 3 bits, most significant bit on the left, top row first
+    const uint8_t DIGIT_GLYPHS[10][DIGIT_ROWS] = {
+        { 0b111, 0b101, 0b101, 0b101, 0b111 },
+        { 0b010, 0b110, 0b010, 0b010, 0b111 },
+        { 0b111, 0b001, 0b111, 0b100, 0b111 },
+        { 0b111, 0b001, 0b111, 0b001, 0b111 },
+        { 0b101, 0b101, 0b111, 0b001, 0b001 },
+        { 0b111, 0b100, 0b111, 0b001, 0b111 },
+        { 0b111, 0b100, 0b111, 0b101, 0b111 },
+        { 0b111, 0b001, 0b001, 0b001, 0b001 },
+        { 0b111, 0b101, 0b111, 0b101, 0b111 },
+        { 0b111, 0b101, 0b111, 0b001, 0b111 },
+    };
+    // the two numbers shown when both light levels are enabled are moved this far apart
+    const float LEVEL_OFFSET = 0.1f;
+}
+
+LightLevelRenderer::~LightLevelRenderer()
+{
+    destroy();
+}
+
+void LightLevelRenderer::setup(gfx::Shader* shader)
+{
+    destroy();
+    m_shader = shader;
+    if (!m_shader)
+        throw std::runtime_error("LightLevelRenderer: Shader pointer is null.");
+
+    // digits side by side in one row, 30x5 texels
+    std::vector<unsigned char> pixels(10 * DIGIT_WIDTH * DIGIT_ROWS);
+    for (int digit = 0; digit < 10; ++digit)
+    {
+        for (int row = 0; row < DIGIT_ROWS; ++row)
+        {
+            for (int col = 0; col < DIGIT_WIDTH; ++col)
+            {
+                bool set = (DIGIT_GLYPHS[digit][row] >> (DIGIT_WIDTH - 1 - col)) & 1;
+                pixels[row * 10 * DIGIT_WIDTH + digit * DIGIT_WIDTH + col] = set ? 255 : 0;
+            }
+        }
+    }
+    glGenTextures(1, &m_digitTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_digitTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, 10 * DIGIT_WIDTH, DIGIT_ROWS, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // the quad corners come from gl_VertexID, so the only attributes are per instance
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_instanceBuffer);
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, center));
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(1);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Instance), (void*)offsetof(Instance, level));
+    glVertexAttribDivisor(1, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_shader->setInt("uDigits", 0);
+    m_shader->setFloat("uDigitHeight", DIGIT_HEIGHT);
+}
+
+void LightLevelRenderer::draw(const ChunkMap& chunkMap, const glm::vec3& cameraPos, int radius, bool showSunLight, bool showBlockLight)
+{
+    if (!m_shader || (!showSunLight && !showBlockLight))
+        return;
+
+    glm::ivec3 cameraBlock = glm::ivec3(glm::floor(cameraPos));
+    auto now = std::chrono::steady_clock::now();
+    bool stale = std::chrono::duration<float, std::milli>(now - m_rebuildTime).count() > REFRESH_MS;
+    if (stale || cameraBlock != m_cameraBlock || radius != m_radius || showSunLight != m_showSunLight || showBlockLight != m_showBlockLight)
+    {
+        m_cameraBlock = cameraBlock;
+        m_radius = radius;
+        m_showSunLight = showSunLight;
+        m_showBlockLight = showBlockLight;
+        m_rebuildTime = now;
+        rebuildInstances(chunkMap);
+
+        // orphaned on every rebuild, the instance count changes with almost every camera move
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(Instance), m_instances.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    if (m_instances.empty())
+        return;
+
+    m_shader->use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_digitTexture);
+    glBindVertexArray(m_vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(m_instances.size()));
+    glBindVertexArray(0);
+}
+
+void LightLevelRenderer::destroy()
+{
+    if (m_vao)
+        glDeleteVertexArrays(1, &m_vao);
+    if (m_instanceBuffer)
+        glDeleteBuffers(1, &m_instanceBuffer);
+    if (m_digitTexture)
+        glDeleteTextures(1, &m_digitTexture);
+    m_vao = 0;
+    m_instanceBuffer = 0;
+    m_digitTexture = 0;
+    m_instances.clear();
+    m_radius = -1;
+}
+
+void LightLevelRenderer::rebuildInstances(const ChunkMap& chunkMap)
+{
+    const int size = Chunk::CHUNK_SIZE;
+    const int radius2 = m_radius * m_radius;
+    m_instances.clear();
+
+    glm::ivec3 minChunk = Chunk::globalToChunkPos(m_cameraBlock - glm::ivec3(m_radius));
+    glm::ivec3 maxChunk = Chunk::globalToChunkPos(m_cameraBlock + glm::ivec3(m_radius));
+    for (int cx = minChunk.x; cx <= maxChunk.x; ++cx)
+    {
+        for (int cy = minChunk.y; cy <= maxChunk.y; ++cy)
+        {
+            for (int cz = minChunk.z; cz <= maxChunk.z; ++cz)
+            {
+                glm::ivec3 origin = glm::ivec3(cx, cy, cz) * size;
+                // skip chunks whose closest block is outside the sphere before looking them up
+                glm::ivec3 closest = glm::clamp(m_cameraBlock, origin, origin + size - 1) - m_cameraBlock;
+                if (closest.x * closest.x + closest.y * closest.y + closest.z * closest.z > radius2)
+                    continue;
+                auto chunk = chunkMap.getChunk(cx, cy, cz);
+                if (!chunk || chunk->isAllSolid())
+                    continue;
+
+                const auto& blocks = chunk->getBlockData();
+                const auto& lights = chunk->getLightData();
+                glm::ivec3 localCamera = m_cameraBlock - origin;
+                int xMin = std::max(0, localCamera.x - m_radius);
+                int xMax = std::min(size - 1, localCamera.x + m_radius);
+                int zMin = std::max(0, localCamera.z - m_radius);
+                int zMax = std::min(size - 1, localCamera.z + m_radius);
+                for (int x = xMin; x <= xMax; ++x)
+                {
+                    int dx = x - localCamera.x;
+                    for (int z = zMin; z <= zMax; ++z)
+                    {
+                        int dz = z - localCamera.z;
+                        int remaining = radius2 - dx * dx - dz * dz;
+                        if (remaining < 0)
+                            continue;
+                        // the sphere's extent along this column, so no block needs a distance test
+                        int dyMax = static_cast<int>(std::sqrt(static_cast<float>(remaining)));
+                        int yMin = std::max(0, localCamera.y - dyMax);
+                        int yMax = std::min(size - 1, localCamera.y + dyMax);
+                        int column = Chunk::getIndex(x, 0, z);
+                        for (int y = yMin; y <= yMax; ++y)
+                        {
+                            int index = column + y;
+                            if (blocks[index] != BlockType::Air)
+                                continue;
+
+                            uint16_t light = lights[index];
+                            uint32_t sunLight = (light >> 12) & 0xF;
+                            uint32_t blockLight = (light >> 8) & 0xF;
+                            glm::vec3 center = glm::vec3(origin + glm::ivec3(x, y, z)) + glm::vec3(0.5f);
+                            if (m_showSunLight && m_showBlockLight)
+                            {
+                                m_instances.push_back({ center - glm::vec3(0.0f, LEVEL_OFFSET, 0.0f), blockLight });
+                                m_instances.push_back({ center + glm::vec3(0.0f, LEVEL_OFFSET, 0.0f), sunLight });
+                            }
+                            else
+                            {
+                                m_instances.push_back({ center, m_showBlockLight ? blockLight : sunLight });
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,246 @@
+#include "graphics/render_benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <spdlog/spdlog.h>
+#include "utils/algorithms.h"
+
+void RenderBenchmark::start(const Camera& camera, const RenderOptions& renderOptions, std::vector<RenderBenchmarkVariant> variants)
+{
+    if (variants.empty())
+        return;
+    m_stage = Stage::Settling;
+    m_variants = std::move(variants);
+    m_variantIndex = -1;
+    m_startPosition = camera.position;
+    m_startYaw = camera.yaw;
+    m_startPitch = camera.pitch;
+    m_prevRenderOptions = renderOptions;
+    m_results.clear();
+}
+
+void RenderBenchmark::update(Camera& camera, WorldRenderer& worldRenderer, float deltaTime)
+{
+    if (m_stage == Stage::Idle)
+        return;
+    if (m_variantIndex < 0)
+    {
+        startVariant(camera, worldRenderer);
+        return;
+    }
+
+    auto& chunkMapRenderer = worldRenderer.getChunkMapRenderer();
+    m_stageTime += deltaTime;
+    if (m_stage == Stage::Settling)
+    {
+        setCamera(camera, 0.0f);
+        bool settled = chunkMapRenderer.getBuildsInFlight() == 0 && chunkMapRenderer.getUploadStats().queuedMeshes == 0;
+        // give the frustum queue a moment to pick up chunks before treating an empty queue as settled
+        if ((settled && m_stageTime > 1.0f) || m_stageTime > SETTLE_TIMEOUT)
+        {
+            if (!settled)
+                spdlog::warn("RenderBenchmark: meshes did not settle within {}s.", SETTLE_TIMEOUT);
+            m_current.arenaBytes = chunkMapRenderer.getMeshArena().getUsedBytes();
+            m_stage = Stage::Flying;
+            m_stageTime = 0.0f;
+        }
+        return;
+    }
+
+    float frameMs = deltaTime * 1000.0f;
+    ++m_current.frames;
+    m_totalFrameMs += frameMs;
+    m_totalDrawnChunks += chunkMapRenderer.getDrawStats().drawnChunks;
+    m_current.maxFrameMs = std::max(m_current.maxFrameMs, frameMs);
+    if (m_stageTime < PATH_DURATION)
+    {
+        setCamera(camera, m_stageTime);
+        return;
+    }
+
+    int frames = std::max(m_current.frames, 1);
+    m_current.avgFrameMs = m_totalFrameMs / frames;
+    m_current.avgDrawnChunks = static_cast<float>(m_totalDrawnChunks) / frames;
+    m_results.push_back(m_current);
+    spdlog::info("RenderBenchmark: {}, {} frames, avg {:.3f}ms, max {:.3f}ms, {:.1f} chunk layers drawn, {:.2f}MB arena.",
+        m_current.name,
+        m_current.frames,
+        m_current.avgFrameMs,
+        m_current.maxFrameMs,
+        m_current.avgDrawnChunks,
+        m_current.arenaBytes / (1024.0f * 1024.0f)
+    );
+
+    if (m_variantIndex + 1 < static_cast<int>(m_variants.size()))
+    {
+        startVariant(camera, worldRenderer);
+        return;
+    }
+    worldRenderer.renderOptions = m_prevRenderOptions;
+    setCamera(camera, 0.0f);
+    m_stage = Stage::Idle;
+}
+
+void RenderBenchmark::startVariant(Camera& camera, WorldRenderer& worldRenderer)
+{
+    ++m_variantIndex;
+    const auto& variant = m_variants[m_variantIndex];
+    m_current = RenderBenchmarkResult();
+    m_current.name = variant.name;
+    m_totalFrameMs = 0.0f;
+    m_totalDrawnChunks = 0;
+    m_stageTime = 0.0f;
+    m_stage = Stage::Settling;
+    worldRenderer.renderOptions = variant.renderOptions;
+    setCamera(camera, 0.0f);
+}
+
+void RenderBenchmark::setCamera(Camera& camera, float pathTime)
+{
+    // fly straight along x while turning, so chunks keep entering and leaving the frustum
+    camera.position = m_startPosition + glm::vec3(pathTime * PATH_SPEED, 0.0f, 0.0f);
+    camera.yaw = m_startYaw + pathTime * PATH_YAW_SPEED;
+    camera.pitch = m_startPitch;
+    camera.rotate(0.0f, 0.0f);
+}
+
+FrustumCullBenchmarkResult benchmarkFrustumCulling(const Frustum& frustum, const glm::vec3& center, int boxCount, int iterations)
+{
+    const float range = 64.0f * Chunk::CHUNK_SIZE;
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> offset(-range, range);
+    AABBList boxes;
+    boxes.reserve(boxCount);
+    for (int i = 0; i < boxCount; ++i)
+    {
+        glm::vec3 min = center + glm::vec3(offset(rng), offset(rng) * 0.25f, offset(rng));
+        boxes.push(min, min + glm::vec3(Chunk::CHUNK_SIZE));
+    }
+
+    FrustumCullBenchmarkResult result;
+    result.boxCount = boxCount;
+    iterations = std::max(iterations, 1);
+
+    std::vector<uint32_t> perBoxVisible;
+    perBoxVisible.reserve(boxCount);
+    auto startTime = std::chrono::steady_clock::now();
+    for (int n = 0; n < iterations; ++n)
+    {
+        perBoxVisible.clear();
+        for (int i = 0; i < boxCount; ++i)
+        {
+            glm::vec3 min{boxes.minX[i], boxes.minY[i], boxes.minZ[i]};
+            glm::vec3 max{boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]};
+            if (frustum.intersectsAABB(min, max))
+                perBoxVisible.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    result.perBoxMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count() / iterations;
+
+    std::vector<uint32_t> batchVisible;
+    batchVisible.reserve(boxCount);
+    startTime = std::chrono::steady_clock::now();
+    for (int n = 0; n < iterations; ++n)
+        frustum.intersectsAABBs(boxes, batchVisible);
+    result.batchMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count() / iterations;
+
+    result.visibleCount = static_cast<int>(batchVisible.size());
+    if (batchVisible != perBoxVisible)
+        spdlog::warn("benchmarkFrustumCulling: batch culling found {} visible boxes, per box culling found {}.", batchVisible.size(), perBoxVisible.size());
+    spdlog::info("benchmarkFrustumCulling: {} boxes, {} visible, per box {:.3f}ms, batch {:.3f}ms.",
+        result.boxCount, result.visibleCount, result.perBoxMs, result.batchMs);
+    return result;
+}
+
+TextBatchBenchmarkResult benchmarkTextBatching(gfx::FontRenderer& fontRenderer, int glyphCount, int iterations)
+{
+    const int labelLength = 100;
+    std::vector<std::string> labels;
+    std::mt19937 rng(1234);
+    const std::string glyphs = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    std::uniform_int_distribution<size_t> glyphIndex(0, glyphs.size() - 1);
+    for (int i = 0; i < glyphCount; i += labelLength)
+    {
+        std::string label(std::min(labelLength, glyphCount - i), ' ');
+        for (char& c : label)
+            c = glyphs[glyphIndex(rng)];
+        labels.push_back(std::move(label));
+    }
+
+    TextBatchBenchmarkResult result;
+    result.glyphCount = glyphCount;
+    iterations = std::max(iterations, 1);
+    float totalMs = 0.0f;
+    const glm::vec4 color(1.0f);
+    for (int n = -1; n < iterations; ++n)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        fontRenderer.beginBatch();
+        for (size_t i = 0; i < labels.size(); ++i)
+            fontRenderer.addText(labels[i], 0.0f, static_cast<float>(i), 1.0f, color);
+        float batchMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        // the first batch loads the glyphs and grows the vertex storage
+        if (n < 0)
+            continue;
+        totalMs += batchMs;
+        result.maxBatchMs = std::max(result.maxBatchMs, batchMs);
+    }
+    result.batchedGlyphs = static_cast<int>(fontRenderer.getGlyphCount());
+    result.avgBatchMs = totalMs / iterations;
+    fontRenderer.clearText();
+    spdlog::info("benchmarkTextBatching: {} glyphs, {} batched, avg {:.3f}ms, max {:.3f}ms.",
+        result.glyphCount, result.batchedGlyphs, result.avgBatchMs, result.maxBatchMs);
+    return result;
+}
+
+RayCastBenchmarkResult benchmarkRayCasting(const ChunkMap& chunkMap, const glm::vec3& origin, float maxDistance, int rayCount)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+    std::vector<algo::VoxelRay> rays;
+    rays.reserve(rayCount);
+    while (static_cast<int>(rays.size()) < rayCount)
+    {
+        glm::vec3 dir(component(rng), component(rng), component(rng));
+        float length2 = glm::dot(dir, dir);
+        if (length2 < 1e-4f || length2 > 1.0f)
+            continue;
+        rays.push_back({origin, dir / std::sqrt(length2), maxDistance});
+    }
+
+    auto isSolid = [](BlockType block) { return block != BlockType::Air && block != BlockType::Water; };
+    RayCastBenchmarkResult result;
+    result.rayCount = rayCount;
+    result.maxDistance = maxDistance;
+
+    std::vector<algo::VoxelRayHitNode> functionHits(rays.size());
+    auto startTime = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rays.size(); ++i)
+    {
+        functionHits[i] = algo::voxelRayHit(rays[i].origin, rays[i].dir, [&](const glm::ivec3& pos) {
+            return isSolid(chunkMap.getBlock(pos));
+        }, rays[i].maxDistance);
+    }
+    result.functionMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::vector<algo::VoxelRayHitNode> cursorHits;
+    startTime = std::chrono::steady_clock::now();
+    ChunkMap::BlockCursor cursor(chunkMap);
+    algo::voxelRayCasts(rays, [&](const glm::ivec3& pos) { return isSolid(cursor.getBlock(pos)); }, cursorHits);
+    result.cursorMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    result.cursorChunkLookups = cursor.getChunkLookups();
+
+    int mismatches = 0;
+    for (size_t i = 0; i < rays.size(); ++i)
+    {
+        if (cursorHits[i].normal != glm::ivec3(0))
+            ++result.hits;
+        if (cursorHits[i].pos != functionHits[i].pos || cursorHits[i].normal != functionHits[i].normal)
+            ++mismatches;
+    }
+    if (mismatches > 0)
+        spdlog::warn("benchmarkRayCasting: {} rays hit different blocks through the cursor.", mismatches);
+    spdlog::info("benchmarkRayCasting: {} rays of {:.0f} blocks, {} hits, std::function {:.3f}ms, cursor {:.3f}ms, {} chunk lookups.",
+        result.rayCount, result.maxDistance, result.hits, result.functionMs, result.cursorMs, result.cursorChunkLookups);
+    return result;
+}
@@ -0,0 +1,140 @@
+#include "graphics/render_debug_panel.h"
+#include <fmt/core.h>
+#include <imgui.h>
+
+void RenderDebugPanel::draw(WorldRenderer& worldRenderer, const Camera& camera, const ChunkMap& chunkMap, ResourceManager& resourceManager)
+{
+    drawStats(worldRenderer);
+    if (ImGui::CollapsingHeader("Benchmark"))
+        drawBenchmarks(worldRenderer, camera, chunkMap, resourceManager);
+}
+
+void RenderDebugPanel::drawStats(WorldRenderer& worldRenderer)
+{
+    ImGui::SliderInt("Max Meshes In Flight", &worldRenderer.renderOptions.maxMeshesInFlight, 1, 512);
+    auto& chunkMapRenderer = worldRenderer.getChunkMapRenderer();
+    ImGui::Text("Mesh Threads: %i", chunkMapRenderer.getBuildThreadCount());
+    ImGui::Text("Meshes In Flight: %i", chunkMapRenderer.getBuildsInFlight());
+    ImGui::SliderInt("Mesh Upload Budget (KB)", &worldRenderer.renderOptions.meshUploadBudgetKB, 64, 16384);
+    ImGui::SliderFloat("Mesh Upload Budget (ms)", &worldRenderer.renderOptions.meshUploadBudgetMs, 0.1f, 16.0f);
+    const auto& uploadStats = chunkMapRenderer.getUploadStats();
+    ImGui::Text("Mesh Uploads: %i (%.1f KB)", uploadStats.uploadsLastFrame, uploadStats.bytesLastFrame / 1024.0f);
+    ImGui::Text("Queued Uploads: %i (%.1f KB)", uploadStats.queuedMeshes, uploadStats.queuedBytes / 1024.0f);
+    ImGui::Text("Upload Stall Frames: %i", uploadStats.stallFrames);
+    const auto& meshArena = chunkMapRenderer.getMeshArena();
+    ImGui::Text("Mesh Arena: %.1f / %.1f MB (%zu free blocks)", 
+        meshArena.getUsedBytes() / (1024.0f * 1024.0f), 
+        meshArena.getCapacityBytes() / (1024.0f * 1024.0f), 
+        meshArena.getFreeBlockCount()
+    );
+    ImGui::Text("Mesh CPU Memory: %.2f MB (%zu meshes)", 
+        chunkMapRenderer.getMeshCPUMemoryUsage() / (1024.0f * 1024.0f), 
+        chunkMapRenderer.getLoadedMeshCount()
+    );
+    auto poolStats = chunkMapRenderer.getMeshPoolStats();
+    ImGui::Text("Mesh Pool: %zu meshes, %zu buffers (%.2f MB)", 
+        poolStats.pooledMeshes, 
+        poolStats.pooledBuffers, 
+        poolStats.pooledBytes / (1024.0f * 1024.0f)
+    );
+    ImGui::Text("Mesh Allocations: %.3f per build (%llu builds)", 
+        poolStats.builds ? static_cast<float>(poolStats.meshAllocations + poolStats.bufferGrowths) / poolStats.builds : 0.0f, 
+        static_cast<unsigned long long>(poolStats.builds)
+    );
+    const auto& drawStats = chunkMapRenderer.getDrawStats();
+    ImGui::Text("Chunk Draws: %i layers in %i %s calls (%.3f ms)", 
+        drawStats.drawnChunks, 
+        drawStats.drawCalls, 
+        meshArena.usesIndirectDraw() ? "indirect" : "base vertex", 
+        drawStats.submitMs
+    );
+    ImGui::Text("Chunk Culling: %.3f ms", drawStats.cullMs);
+    ImGui::Text("Chunks per LOD: %i / %i / %i / %i", 
+        drawStats.lodChunks[0], 
+        drawStats.lodChunks[1], 
+        drawStats.lodChunks[2], 
+        drawStats.lodChunks[3]
+    );
+    ImGui::Text("Visible Set Search: %.3f ms (%i frames ago)", drawStats.searchMs, drawStats.framesSinceSearch);
+    ImGui::Checkbox("Use Face Pulling", &worldRenderer.renderOptions.useFacePulling);
+    ImGui::Checkbox("Use Cave Culling", &worldRenderer.renderOptions.useCaveCulling);
+    ImGui::Checkbox("Use Occlusion Culling", &worldRenderer.renderOptions.useOcclusionCulling);
+    ImGui::Text("Occlusion: %i occluders, %i chunks hidden (%.3f ms)", 
+        drawStats.occluders, 
+        drawStats.occludedChunks, 
+        drawStats.occlusionMs
+    );
+}
+
+void RenderDebugPanel::drawBenchmarks(WorldRenderer& worldRenderer, const Camera& camera, const ChunkMap& chunkMap, ResourceManager& resourceManager)
+{
+    // each benchmark flies the same path from the current position once per variant
+    auto startBenchmark = [&](const char* optionName, bool RenderOptions::* option) {
+        RenderOptions offOptions = worldRenderer.renderOptions;
+        RenderOptions onOptions = worldRenderer.renderOptions;
+        offOptions.*option = false;
+        onOptions.*option = true;
+        m_renderBenchmark.start(camera, worldRenderer.renderOptions, {
+            {fmt::format("{} off", optionName), offOptions},
+            {fmt::format("{} on", optionName), onOptions}
+        });
+    };
+    if (m_renderBenchmark.isRunning()) {
+        ImGui::Text("Benchmark running...");
+    } else {
+        if (ImGui::Button("Compare Face Pulling"))
+            startBenchmark("Face pulling", &RenderOptions::useFacePulling);
+        if (ImGui::Button("Compare Cave Culling"))
+            startBenchmark("Cave culling", &RenderOptions::useCaveCulling);
+        if (ImGui::Button("Compare Occlusion Culling"))
+            startBenchmark("Occlusion culling", &RenderOptions::useOcclusionCulling);
+        if (ImGui::Button("Frustum Cull 30k Boxes"))
+            m_frustumCullBenchmark = benchmarkFrustumCulling(camera.getFrustum(), camera.position);
+        if (ImGui::Button("Batch 100k Glyphs")) {
+            if (auto fontRenderer = resourceManager.getFontRenderer("default"))
+                m_textBatchBenchmark = benchmarkTextBatching(*fontRenderer);
+        }
+        if (ImGui::Button("Raycast 10k Rays")) {
+            // picking distance, then a line of sight distance
+            m_rayCastBenchmarks = {
+                benchmarkRayCasting(chunkMap, camera.position, 20.0f),
+                benchmarkRayCasting(chunkMap, camera.position, 128.0f)
+            };
+        }
+    }
+    if (m_frustumCullBenchmark.boxCount > 0) {
+        ImGui::Text("Frustum Cull: %i boxes, %i visible, per box %.3f ms, batch %.3f ms", 
+            m_frustumCullBenchmark.boxCount, 
+            m_frustumCullBenchmark.visibleCount, 
+            m_frustumCullBenchmark.perBoxMs, 
+            m_frustumCullBenchmark.batchMs
+        );
+    }
+    if (m_textBatchBenchmark.glyphCount > 0) {
+        ImGui::Text("Text Batch: %i glyphs, %i batched, avg %.3f ms, max %.3f ms", 
+            m_textBatchBenchmark.glyphCount, 
+            m_textBatchBenchmark.batchedGlyphs, 
+            m_textBatchBenchmark.avgBatchMs, 
+            m_textBatchBenchmark.maxBatchMs
+        );
+    }
+    for (const auto& result : m_rayCastBenchmarks) {
+        ImGui::Text("Raycast %.0f: %i rays, %i hits, std::function %.3f ms, cursor %.3f ms, %i lookups", 
+            result.maxDistance, 
+            result.rayCount, 
+            result.hits, 
+            result.functionMs, 
+            result.cursorMs, 
+            result.cursorChunkLookups
+        );
+    }
+    for (const auto& result : m_renderBenchmark.getResults()) {
+        ImGui::Text("%s: avg %.3f ms, max %.3f ms, %.1f layers, %.2f MB", 
+            result.name.c_str(), 
+            result.avgFrameMs, 
+            result.maxFrameMs, 
+            result.avgDrawnChunks, 
+            result.arenaBytes / (1024.0f * 1024.0f)
+        );
+    }
+}
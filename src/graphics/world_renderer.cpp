@@ -7,9 +7,16 @@ WorldRenderer::WorldRenderer(ChunkMap* chunkMap, ResourceManager* resourceManage
     m_chunkMapRenderer(chunkMap) 
 {}
 
-void WorldRenderer::update()
+void WorldRenderer::update(const Camera& camera)
 {
-    m_chunkMapRenderer.updateBuildQueue(renderOptions.useSmoothLighting);
+    m_chunkMapRenderer.setMaxBuildsInFlight(renderOptions.maxMeshesInFlight);
+    m_chunkMapRenderer.setUploadBudget(static_cast<size_t>(renderOptions.meshUploadBudgetKB) * 1024, renderOptions.meshUploadBudgetMs);
+    m_chunkMapRenderer.setCaveCulling(renderOptions.useCaveCulling);
+    m_chunkMapRenderer.setMeshFormat(renderOptions.useFacePulling ? ChunkMeshFormat::Faces : ChunkMeshFormat::Vertices);
+    m_chunkMapRenderer.setOcclusionCulling(renderOptions.useOcclusionCulling);
+    m_chunkMapRenderer.setLodDistance(renderOptions.lodDistance);
+    m_chunkMapRenderer.updateBuildQueue(Chunk::globalToChunkPos(camera.position), renderOptions.useSmoothLighting);
+    m_chunkMapRenderer.updateOcclusion(camera);
 }
 
 void WorldRenderer::loadResources()
@@ -18,19 +25,39 @@ void WorldRenderer::loadResources()
 
     m_chunkMapRenderer.setupResources(
         m_resourceManager->getShader("chunk"),
-        m_resourceManager->getTextureAtlas<BlockTexture>("chunk_atlas")
+        m_resourceManager->getShader("chunk_faces"),
+        m_resourceManager->getTextureArray<BlockTexture>("block_textures")
     );
+    m_frameDataBuffer.setup(sizeof(FrameData), FrameData::BINDING);
+    m_lightLevelRenderer.setup(m_resourceManager->getShader("light_levels"));
+    if (auto lineShader = m_resourceManager->getShader("line"))
+        m_lineWidthLocation = lineShader->getUniformLocation("uLineWidth");
 }
 
-void WorldRenderer::draw(const Camera& camera, GameWindow& window, float dayNightFrac)
+void WorldRenderer::updateFrameData(const Camera& camera, float dayNightFrac)
+{
+    m_frameData.view = camera.getViewMatrix();
+    m_frameData.projection = camera.getProjectionMatrix();
+    m_frameData.viewProjection = m_frameData.projection * m_frameData.view;
+    m_frameData.invViewProjection = glm::inverse(m_frameData.viewProjection);
+    m_frameData.cameraPos = glm::vec4(camera.position, 1.0f);
+    m_frameData.resolution = glm::vec2(camera.framebufferSize);
+    m_frameData.dayNightFrac = dayNightFrac;
+    m_frameData.aoIntensity = renderOptions.aoFactor;
+    m_frameData.aoEnabled = renderOptions.useAO ? 1 : 0;
+    m_frameDataBuffer.update(&m_frameData, sizeof(FrameData));
+    m_frameDataBuffer.bind();
+}
+
+void WorldRenderer::draw(const Camera& camera, GameWindow& window)
 {
     checkPointers();
-    m_chunkMapRenderer.draw(camera, renderOptions.renderDistance, renderOptions.useAO, renderOptions.aoFactor, dayNightFrac);
+    m_chunkMapRenderer.draw(camera, renderOptions.renderDistance);
 
     if (renderOptions.showChunkBorder)
     {
         auto chunkPos = Chunk::globalToChunkPos(camera.position);
-        drawChunkBorder(glm::vec3(chunkPos.x, chunkPos.y, chunkPos.z), camera, window);
+        drawChunkBorder(glm::vec3(chunkPos.x, chunkPos.y, chunkPos.z), window);
     }
 
     if (renderOptions.showSunLightLevels || renderOptions.showBlockLightLevels)
@@ -45,7 +72,7 @@ void WorldRenderer::checkPointers() const
         throw std::runtime_error("WorldRenderer: ResourceManager pointer is null.");
 }
 
-void WorldRenderer::drawChunkBorder(const glm::ivec3 &chunkPos, const Camera &camera, GameWindow& window)
+void WorldRenderer::drawChunkBorder(const glm::ivec3 &chunkPos, GameWindow& window)
 {
     checkPointers();
     auto lineRenderer = m_resourceManager->getLineRenderer("default");
@@ -68,11 +95,7 @@ void WorldRenderer::drawChunkBorder(const glm::ivec3 &chunkPos, const Camera &ca
     if (isCulled)
         window.disableCulling();
     lineShader->use();
-    lineShader->setMat4("uProjection", camera.getProjectionMatrix());
-    lineShader->setMat4("uView", camera.getViewMatrix());
-    lineShader->setMat4("uModel", glm::mat4(1.0f));
-    lineShader->setFloat("uLineWidth", 1.0f);
-    lineShader->setVec2("uResolution", camera.framebufferSize);
+    lineShader->setFloat(m_lineWidthLocation, 1.0f);
     lineRenderer->draw();
     if (isCulled)
         window.enableCulling();
@@ -81,74 +104,11 @@ void WorldRenderer::drawChunkBorder(const glm::ivec3 &chunkPos, const Camera &ca
 void WorldRenderer::showLightLevels(const Camera& camera)
 {
     checkPointers();
-    auto fontRenderer = m_resourceManager->getFontRenderer("default_billboard");
-    auto fontShader = m_resourceManager->getShader("font_billboard");
-
-    fontShader->use();
-    fontShader->setMat4("uProjection", camera.getProjectionMatrix());
-    fontShader->setMat4("uView", camera.getViewMatrix());
-    fontShader->setMat4("uModel", glm::mat4(1.0f));
-    fontRenderer->beginBatch();
-
-    int radius = renderOptions.showLightLevelRadius;
-    glm::vec3 cameraPos = camera.position;
-
-    int chunkRadius = radius / Chunk::CHUNK_SIZE + 1;
-
-    auto chunks = m_chunkMap->getChunksInRadius(Chunk::globalToChunkPos(cameraPos), chunkRadius);
-
-    for (auto chunk : chunks) {
-        auto min = cameraPos - glm::vec3(radius, radius, radius);
-        auto max = cameraPos + glm::vec3(radius, radius, radius);
-        
-        // local positions that could be out of bounds
-        auto chunkOrigin = Chunk::localToGlobalPos({0,0,0}, chunk->getPos());
-        auto localMin = glm::ivec3(min) - chunkOrigin;
-        auto localMax = glm::ivec3(max) - chunkOrigin;
-        localMin = glm::clamp(localMin, 0, Chunk::CHUNK_SIZE - 1);
-        localMax = glm::clamp(localMax, 0, Chunk::CHUNK_SIZE - 1);
-        auto localCam = cameraPos - glm::vec3(chunkOrigin);
-        
-        for (int x = localMin.x; x <= localMax.x; ++x) {
-            for (int z = localMin.z; z <= localMax.z; ++z) {
-                for (int y = localMin.y; y <= localMax.y; ++y) {
-                    glm::vec3 d = glm::vec3(x, y, z) - localCam;
-                    if ((d.x * d.x + d.y * d.y + d.z * d.z) > radius * radius)
-                        continue;
-                    glm::ivec3 pos = {x, y, z};
-
-                    if (x < 0 || x >= Chunk::CHUNK_SIZE || y < 0 || y >= Chunk::CHUNK_SIZE || z < 0 || z >= Chunk::CHUNK_SIZE)
-                        continue;
-
-                    if (chunk->getBlock(pos) != BlockType::Air)
-                        continue;
-                    
-                    auto sunLight = chunk->getSunLight(pos);
-                    auto blockLight = chunk->getBlockLight(pos);
-
-                    float sunColor = static_cast<float>(sunLight) / 15.0f;
-                    float blockColor = static_cast<float>(blockLight) / 15.0f;
-                    glm::vec4 sunTextColor = glm::vec4(1.0f - sunColor, sunColor, 0.2f, 1.0f);
-                    glm::vec4 blockTextColor = glm::vec4(1.0f - blockColor, blockColor, 0.2f, 1.0f);
-                    glm::vec3 textPos = glm::vec3(pos) + glm::vec3(chunk->getPos() * Chunk::CHUNK_SIZE) + glm::vec3(0.5f, 0.5f, 0.5f);
-                    if (renderOptions.showSunLightLevels && renderOptions.showBlockLightLevels) {
-                        fontRenderer->addTextBB(std::to_string(blockLight), {0,0,0}, {textPos.x, textPos.y - 0.1f, textPos.z}, 0.003f, blockTextColor, true);
-                        fontRenderer->addTextBB(std::to_string(sunLight), {0,0,0}, {textPos.x, textPos.y + 0.1f, textPos.z}, 0.003f, sunTextColor, true);
-                    } else {
-                        if (renderOptions.showBlockLightLevels) {
-                            fontRenderer->addTextBB(std::to_string(blockLight), {0,0,0}, textPos, 0.003f, blockTextColor, true);
-                        } else {
-                            fontRenderer->addTextBB(std::to_string(sunLight), {0,0,0}, textPos, 0.003f, sunTextColor, true);
-                        }
-                    }
-                }
-            }
-        }
-    }
-    fontRenderer->draw();
+    m_lightLevelRenderer.draw(*m_chunkMap, camera.position, static_cast<int>(renderOptions.showLightLevelRadius),
+        renderOptions.showSunLightLevels, renderOptions.showBlockLightLevels);
 }
 
-void WorldRenderer::highlightVoxels(const std::vector<glm::ivec3>& voxels, const Camera &camera, GameWindow& window)
+void WorldRenderer::highlightVoxels(const std::vector<glm::ivec3>& voxels, GameWindow& window)
 {
     checkPointers();
     auto lineRenderer = m_resourceManager->getLineRenderer("default");
@@ -163,17 +123,13 @@ void WorldRenderer::highlightVoxels(const std::vector<glm::ivec3>& voxels, const
     if (isCulled)
         window.disableCulling();
     lineShader->use();
-    lineShader->setMat4("uProjection", camera.getProjectionMatrix());
-    lineShader->setMat4("uView", camera.getViewMatrix());
-    lineShader->setMat4("uModel", glm::mat4(1.0f));
-    lineShader->setFloat("uLineWidth", 2.0f);
-    lineShader->setVec2("uResolution", camera.framebufferSize);
+    lineShader->setFloat(m_lineWidthLocation, 2.0f);
     lineRenderer->draw();
     if (isCulled)
         window.enableCulling();
 }
 
-void WorldRenderer::showFrustum(const glm::mat4& mat, const Camera& camera, GameWindow& window)
+void WorldRenderer::showFrustum(const glm::mat4& mat, GameWindow& window)
 {
     checkPointers();
     auto lineRenderer = m_resourceManager->getLineRenderer("default");
@@ -212,11 +168,7 @@ void WorldRenderer::showFrustum(const glm::mat4& mat, const Camera& camera, Game
     if (isCulled)
         window.disableCulling();
     lineShader->use();
-    lineShader->setMat4("uProjection", camera.getProjectionMatrix());
-    lineShader->setMat4("uView", camera.getViewMatrix());
-    lineShader->setMat4("uModel", glm::mat4(1.0f));
-    lineShader->setFloat("uLineWidth", 2.0f);
-    lineShader->setVec2("uResolution", camera.framebufferSize);
+    lineShader->setFloat(m_lineWidthLocation, 2.0f);
     lineRenderer->draw();
     if (isCulled)
         window.enableCulling();
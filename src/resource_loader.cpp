@@ -2,6 +2,50 @@
 #include "resource_manager.h"
 #include "world/block_data.h"
 #include "graphics/gfx/texture_atlas.h"
+#include "graphics/frame_data.h"
+#include <chrono>
+#include <algorithm>
+
+namespace
+{
+    const char* ASSET_CACHE_PATH = "cache/assets.bin";
+    const char* SHADER_CACHE_DIR = "cache/shaders";
+    const char* BLOCK_TEXTURE_DIR = "res/textures/";
+
+    struct FontSpec
+    {
+        const char* name;
+        const char* path;
+        unsigned int fontSize;
+        bool useBillboard;
+    };
+
+    const FontSpec FONTS[] = {
+        { "default", "res/fonts/arial.ttf", 48, false },
+        { "default_billboard", "res/fonts/courier-mon.ttf", 48, true },
+    };
+
+    // inserts the FrameData block right after the #version line. The #line directive keeps
+    // compile errors pointing at the lines of the file on disk
+    void addFrameDataBlock(std::string& source)
+    {
+        if (source.empty())
+            return;
+        size_t insertAt = 0;
+        int nextLine = 1;
+        if (source.compare(0, 8, "#version") == 0)
+        {
+            size_t lineEnd = source.find('\n');
+            insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+            nextLine = 2;
+        }
+        std::string block = FrameData::GLSL_BLOCK;
+        if (insertAt == source.size() && source.back() != '\n')
+            block.insert(block.begin(), '\n');
+        block += "#line " + std::to_string(nextLine) + "\n";
+        source.insert(insertAt, block);
+    }
+}
 
 ResourceLoader::ResourceLoader(ResourceManager* resourceManager) : m_resourceManager(resourceManager) {}
 
@@ -10,19 +54,19 @@ void ResourceLoader::load(const glm::ivec2& frameBufferSize)
     if (!m_resourceManager)
         throw std::runtime_error("ResourceLoader: ResourceManager pointer is null.");
 
-    // Load shaders
-    m_resourceManager->loadShader("line", "res/shaders/line_renderer.vert", "res/shaders/line_renderer.frag");
-    m_resourceManager->loadShader("font", "res/shaders/font_renderer.vert", "res/shaders/font_renderer.frag");
-    m_resourceManager->loadShader("font_billboard", "res/shaders/font_renderer_billboard.vert", "res/shaders/font_renderer.frag");
-    m_resourceManager->loadShader("screen_quad", "res/shaders/screen_quad.vert", "res/shaders/screen_quad.frag");
-    m_resourceManager->loadShader("sky_color", "res/shaders/sky_color.vert", "res/shaders/sky_color.frag");
-    m_resourceManager->loadShader("chunk", "res/shaders/terrain_chunk.vert", "res/shaders/terrain_chunk.frag");
+    m_loadStart = std::chrono::steady_clock::now();
 
-    // Load Fonts
-    auto fontRenderer = m_resourceManager->loadFontRenderer("default", "res/fonts/arial.ttf", 48);
-    fontRenderer->preloadDefaultGlyphs();
-    auto fontRendererBB = m_resourceManager->loadFontRenderer("default_billboard", "res/fonts/courier-mon.ttf", 48, true);
-    fontRendererBB->preloadDefaultGlyphs();
+    // Load shaders. The sources are read in parallel and compiled, or loaded from the program
+    // binary cache, once finishJobs runs
+    gfx::Shader::setBinaryCacheDir(SHADER_CACHE_DIR);
+    loadShader("line", "res/shaders/line_renderer.vert", "res/shaders/line_renderer.frag");
+    loadShader("font", "res/shaders/font_renderer.vert", "res/shaders/font_renderer.frag");
+    loadShader("font_billboard", "res/shaders/font_renderer_billboard.vert", "res/shaders/font_renderer.frag");
+    loadShader("screen_quad", "res/shaders/screen_quad.vert", "res/shaders/screen_quad.frag");
+    loadShader("sky_color", "res/shaders/sky_color.vert", "res/shaders/sky_color.frag");
+    loadShader("chunk", "res/shaders/terrain_chunk.vert", "res/shaders/terrain_chunk.frag");
+    loadShader("chunk_faces", "res/shaders/terrain_chunk_faces.vert", "res/shaders/terrain_chunk.frag");
+    loadShader("light_levels", "res/shaders/light_levels.vert", "res/shaders/light_levels.frag");
 
     // Load RenderTargets and ScreenQuads
     m_resourceManager->addRenderTarget("game_target", frameBufferSize.x, frameBufferSize.y);
@@ -32,11 +76,13 @@ void ResourceLoader::load(const glm::ivec2& frameBufferSize)
     // Load LineRenderer
     m_resourceManager->addLineRenderer("default");
 
-    // Setup Atlas
-    auto atlas = m_resourceManager->addTextureAtlas<BlockTexture>("chunk_atlas", { .internalFilterMin = GL_NEAREST_MIPMAP_LINEAR, .internalFilterMag = GL_NEAREST });
+    // Setup block textures. Chunks sample the texture array, the atlas only holds the block icons for the UI
+    auto blockTextures = m_resourceManager->addTextureArray<BlockTexture>("block_textures", {});
+    m_resourceManager->addTextureAtlas<BlockTexture>("block_icon_atlas", { .internalFilterMin = GL_NEAREST, .internalFilterMag = GL_NEAREST });
 
-    setupChunkAtlas();
-    atlas->generateMipmaps(4);
+    // Load fonts and block textures, then wait for every job including the shaders
+    loadCachedAssets();
+    blockTextures->generateMipmaps(4);
 
     // setup BlockData
     BlockData::submitBlockData(BlockType::Air, { .isTransparent = true, .isLiquid = false, .isCube = false });
@@ -54,32 +100,202 @@ void ResourceLoader::load(const glm::ivec2& frameBufferSize)
     BlockData::submitBlockTextureData(BlockType::Sand, BlockTextureData(BlockTexture::Sand));
     BlockData::submitBlockTextureData(BlockType::Water, BlockTextureData(BlockTexture::Water, BlockTexture::Water, BlockTexture::Water, BlockTexture::Water, BlockTexture::Water, BlockTexture::Water));
     BlockData::submitBlockTextureData(BlockType::Lamp, BlockTextureData(BlockTexture::Lamp));
+
+    spdlog::info("ResourceLoader: Finished loading in {:.2f} ms.", getLoadMs());
 }
 
-void ResourceLoader::setupChunkAtlas()
+void ResourceLoader::launchJob(const std::string& label, DecodeFunc decode)
 {
-    auto atlas = m_resourceManager->getTextureAtlas<BlockTexture>("chunk_atlas");
-    if (!atlas)
+    auto decodedAtMs = std::make_shared<float>(0.0f);
+    auto future = std::async(std::launch::async, [this, decode = std::move(decode), decodedAtMs]() {
+        auto upload = decode();
+        *decodedAtMs = getLoadMs();
+        return upload;
+    });
+    m_jobs.push_back({ label, std::move(future), decodedAtMs });
+}
+
+int ResourceLoader::finishJobs()
+{
+    int failedJobs = 0;
+    while (!m_jobs.empty())
     {
-        spdlog::error("ResourceLoader: Chunk atlas not found.");
-        return;
+        auto it = std::find_if(m_jobs.begin(), m_jobs.end(), [](const AssetJob& job) {
+            return job.upload.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        });
+        if (it == m_jobs.end())
+        {
+            m_jobs.front().upload.wait_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        AssetJob job = std::move(*it);
+        m_jobs.erase(it);
+        auto upload = job.upload.get();
+        float uploadStartMs = getLoadMs();
+        if (upload)
+            upload();
+        else
+            ++failedJobs;
+        spdlog::info("ResourceLoader: {} decoded at {:.2f} ms, uploaded at {:.2f} ms ({:.2f} ms on the main thread).",
+            job.label, *job.decodedAtMs, getLoadMs(), getLoadMs() - uploadStartMs);
     }
+    return failedJobs;
+}
+
+float ResourceLoader::getLoadMs() const
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_loadStart).count();
+}
+
+void ResourceLoader::loadShader(const std::string& name, const std::string& vertPath, const std::string& fragPath)
+{
+    launchJob("shader " + name, [this, name, vertPath, fragPath]() -> std::function<void()> {
+        auto sources = std::make_shared<gfx::ShaderSources>(gfx::Shader::readSources(vertPath, fragPath));
+        addFrameDataBlock(sources->vertex);
+        addFrameDataBlock(sources->fragment);
+        addFrameDataBlock(sources->geometry);
+        return [this, name, sources]() {
+            gfx::Shader shader;
+            shader.loadFromSource(*sources);
+            shader.bindUniformBlock(FrameData::BLOCK_NAME, FrameData::BINDING);
+            m_resourceManager->addShader(name, std::move(shader));
+        };
+    });
+}
+
+void ResourceLoader::loadCachedAssets()
+{
+    float startMs = getLoadMs();
 
-    for (const auto& dirEntry : std::filesystem::directory_iterator("res/textures/"))
+    std::vector<std::string> sourcePaths;
+    for (const auto& dirEntry : std::filesystem::directory_iterator(BLOCK_TEXTURE_DIR))
     {
         if (dirEntry.is_regular_file())
+            sourcePaths.push_back(dirEntry.path().string());
+    }
+    // directory order is unspecified, the hash must not depend on it
+    std::sort(sourcePaths.begin(), sourcePaths.end());
+    size_t textureCount = sourcePaths.size();
+
+    const std::wstring& glyphSet = gfx::FontRenderer::getDefaultGlyphs();
+    std::string extraKey(reinterpret_cast<const char*>(glyphSet.data()), glyphSet.size() * sizeof(wchar_t));
+    for (const auto& font : FONTS)
+    {
+        sourcePaths.push_back(font.path);
+        extraKey += fmt::format("|{}:{}", font.path, font.fontSize);
+    }
+    uint64_t sourceHash = AssetCache::hashSources(sourcePaths, extraKey);
+
+    AssetCache cache;
+    bool fromCache = cache.open(ASSET_CACHE_PATH, sourceHash);
+
+    // a miss decodes and rasterizes everything and keeps the results to write the new cache.
+    // The upload steps that fill these run on this thread, so they need no locking
+    std::vector<std::vector<unsigned char>> decodedPixels;
+    decodedPixels.reserve(textureCount);
+    std::vector<AssetCache::Texture> textures;
+    std::vector<AssetCache::Font> fonts;
+    // a cache baked without some of the assets would be accepted by every later launch, so
+    // nothing is written if any of them failed
+    int failedAssets = 0;
+
+    for (const auto& spec : FONTS)
+    {
+        // creating the face shares the FreeType library and stays on this thread. Each font has
+        // its own face, so rasterizing different fonts in parallel is safe
+        auto fontRenderer = m_resourceManager->loadFontRenderer(spec.name, spec.path, spec.fontSize, spec.useBillboard);
+        if (!fontRenderer)
+        {
+            ++failedAssets;
+            continue;
+        }
+        const AssetCache::Font* cachedFont = fromCache ? cache.getFont(spec.path, spec.fontSize) : nullptr;
+        if (cachedFont)
+        {
+            fontRenderer->addGlyphs(cachedFont->glyphs);
+            continue;
+        }
+        launchJob(fmt::format("font {}", spec.name), [fontRenderer, &glyphSet, &fonts, spec]() -> std::function<void()> {
+            auto font = std::make_shared<AssetCache::Font>(AssetCache::Font{ spec.path, spec.fontSize, fontRenderer->rasterizeGlyphs(glyphSet) });
+            return [fontRenderer, font, &fonts]() {
+                fontRenderer->addGlyphs(font->glyphs);
+                fonts.push_back(std::move(*font));
+            };
+        });
+    }
+
+    if (fromCache)
+    {
+        for (const auto& texture : cache.getTextures())
+            addBlockTexture(texture);
+    }
+    else
+    {
+        for (size_t i = 0; i < textureCount; ++i)
         {
-            auto filePath = dirEntry.path().string();
-            auto fileName = dirEntry.path().stem().string();
-            auto it = BlockData::stringToBlockTexture.find(fileName);
-            if (it == BlockData::stringToBlockTexture.end())
-            {
-                spdlog::warn("ResourceLoader: Texture {} not found in StringToBlockTexture map.", fileName);
-                continue;
-            }
-            BlockTexture blockTexture = it->second;
-            spdlog::info("Loading texture: {}", filePath);
-            auto[uvMin, uvMax] = atlas->addImgFromPath(blockTexture, filePath);
+            const std::string filePath = sourcePaths[i];
+            launchJob("texture " + filePath, [this, filePath, &decodedPixels, &textures]() -> std::function<void()> {
+                int width, height, channels;
+                unsigned char* data = stbi_load(filePath.c_str(), &width, &height, &channels, 4);
+                if (!data)
+                {
+                    spdlog::error("ResourceLoader: Failed to load texture from file: {}", filePath);
+                    return nullptr;
+                }
+                auto pixels = std::make_shared<std::vector<unsigned char>>(data, data + static_cast<size_t>(width) * height * 4);
+                stbi_image_free(data);
+                return [this, filePath, pixels, width, height, &decodedPixels, &textures]() {
+                    // moving the vector keeps its buffer, so the pointer stays valid for the cache write
+                    decodedPixels.push_back(std::move(*pixels));
+                    std::string fileName = std::filesystem::path(filePath).stem().string();
+                    textures.push_back({ fileName, static_cast<unsigned int>(width), static_cast<unsigned int>(height), decodedPixels.back().data() });
+                    addBlockTexture(textures.back());
+                };
+            });
         }
     }
-}
\ No newline at end of file
+
+    failedAssets += finishJobs();
+
+    if (!fromCache && failedAssets > 0)
+    {
+        spdlog::warn("ResourceLoader: {} assets failed to load, not writing asset cache {}.", failedAssets, ASSET_CACHE_PATH);
+    }
+    else if (!fromCache)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(ASSET_CACHE_PATH).parent_path(), ec);
+        if (ec || !AssetCache::write(ASSET_CACHE_PATH, sourceHash, textures, fonts))
+            spdlog::warn("ResourceLoader: Failed to write asset cache {}.", ASSET_CACHE_PATH);
+    }
+
+    float elapsedMs = getLoadMs() - startMs;
+    if (fromCache)
+        spdlog::info("ResourceLoader: Loaded textures and glyphs from {} in {:.2f} ms.", ASSET_CACHE_PATH, elapsedMs);
+    else if (failedAssets > 0)
+        spdlog::info("ResourceLoader: Decoded textures and rasterized glyphs in {:.2f} ms.", elapsedMs);
+    else
+        spdlog::info("ResourceLoader: Decoded textures and rasterized glyphs in {:.2f} ms and baked {}.", elapsedMs, ASSET_CACHE_PATH);
+}
+
+void ResourceLoader::addBlockTexture(const AssetCache::Texture& texture)
+{
+    auto blockTextures = m_resourceManager->getTextureArray<BlockTexture>("block_textures");
+    auto atlas = m_resourceManager->getTextureAtlas<BlockTexture>("block_icon_atlas");
+    if (!blockTextures || !atlas)
+    {
+        spdlog::error("ResourceLoader: Block texture array or icon atlas not found.");
+        return;
+    }
+
+    auto it = BlockData::stringToBlockTexture.find(texture.name);
+    if (it == BlockData::stringToBlockTexture.end())
+    {
+        spdlog::warn("ResourceLoader: Texture {} not found in StringToBlockTexture map.", texture.name);
+        return;
+    }
+    BlockTexture blockTexture = it->second;
+    blockTextures->add(blockTexture, texture.pixels, texture.width, texture.height);
+    atlas->add(blockTexture, texture.pixels, texture.width, texture.height);
+}
@@ -8,40 +8,7 @@ namespace algo
         std::function<bool (const glm::ivec3&)> hitCondition, 
         float maxDistance)
     {
-        glm::ivec3 v = glm::floor(origin);
-        glm::ivec3 step = glm::sign(dir);
-        float tmaxX = dir.x != 0.0f ? (v.x + (step.x > 0 ? 1 : 0) - origin.x) / dir.x : std::numeric_limits<float>::max();
-        float tmaxY = dir.y != 0.0f ? (v.y + (step.y > 0 ? 1 : 0) - origin.y) / dir.y : std::numeric_limits<float>::max();
-        float tmaxZ = dir.z != 0.0f ? (v.z + (step.z > 0 ? 1 : 0) - origin.z) / dir.z : std::numeric_limits<float>::max();
-
-        float tDeltaX = step.x != 0.0f ? std::abs(1.0f / dir.x) : std::numeric_limits<float>::max();
-        float tDeltaY = step.y != 0.0f ? std::abs(1.0f / dir.y) : std::numeric_limits<float>::max();
-        float tDeltaZ = step.z != 0.0f ? std::abs(1.0f / dir.z) : std::numeric_limits<float>::max();
-
-        glm::ivec3 hitNormal;
-        float tTotal = std::min({tmaxX, tmaxY, tmaxZ});
-
-        while (tTotal < maxDistance) {
-            if (tmaxX < tmaxY && tmaxX < tmaxZ) {
-                v.x += step.x;
-                tmaxX += tDeltaX;
-                hitNormal = glm::ivec3(-step.x, 0, 0);
-            } else if (tmaxY < tmaxZ) {
-                v.y += step.y;
-                tmaxY += tDeltaY;
-                hitNormal = glm::ivec3(0, -step.y, 0);
-            } else {
-                v.z += step.z;
-                tmaxZ += tDeltaZ;
-                hitNormal = glm::ivec3(0, 0, -step.z);
-            }
-            tTotal = std::min({tmaxX, tmaxY, tmaxZ});
-
-            if (hitCondition(v)) {
-                return {v, hitNormal};
-            }
-        }
-        return {v, glm::ivec3(0)}; // No hit found
+        return voxelRayCast(origin, dir, hitCondition, maxDistance);
     }
 
     std::vector<VoxelRayHitNode> voxelRayTraversal(
@@ -112,4 +79,15 @@ namespace algo
 
         return positions;
     }
-}
\ No newline at end of file
+
+    uint64_t fnv1a(const void* data, size_t size, uint64_t hash)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+}
@@ -1,4 +1,8 @@
 #include "utils/geometry.h"
+#include <bit>
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
 
 Frustum::Frustum(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix) {
     glm::mat4 clipMatrix = projectionMatrix * viewMatrix;
@@ -41,4 +45,99 @@ bool Frustum::intersectsAABB(const glm::vec3& min, const glm::vec3& max) const {
         }
     }
     return true;
-}
\ No newline at end of file
+}
+
+Frustum Frustum::padded(float distance) const {
+    // planes are normalized, so d is in world units
+    Frustum frustum = *this;
+    for (auto& plane : frustum.planes)
+        plane.d += distance;
+    return frustum;
+}
+
+void AABBList::clear()
+{
+    minX.clear(); minY.clear(); minZ.clear();
+    maxX.clear(); maxY.clear(); maxZ.clear();
+}
+
+void AABBList::reserve(size_t count)
+{
+    minX.reserve(count); minY.reserve(count); minZ.reserve(count);
+    maxX.reserve(count); maxY.reserve(count); maxZ.reserve(count);
+}
+
+void AABBList::push(const glm::vec3& min, const glm::vec3& max)
+{
+    minX.push_back(min.x); minY.push_back(min.y); minZ.push_back(min.z);
+    maxX.push_back(max.x); maxY.push_back(max.y); maxZ.push_back(max.z);
+}
+
+void Frustum::intersectsAABBs(const AABBList& boxes, std::vector<uint32_t>& visibleOut) const {
+    visibleOut.clear();
+    size_t count = boxes.size();
+
+    // the positive vertex only depends on the plane, so pick the min or max array once per plane
+    struct PlaneInput {
+        const float* x;
+        const float* y;
+        const float* z;
+    };
+    std::array<PlaneInput, 6> inputs;
+    for (int p = 0; p < 6; ++p) {
+        const glm::vec3& n = planes[p].normal;
+        inputs[p] = {
+            n.x >= 0 ? boxes.maxX.data() : boxes.minX.data(),
+            n.y >= 0 ? boxes.maxY.data() : boxes.minY.data(),
+            n.z >= 0 ? boxes.maxZ.data() : boxes.minZ.data()
+        };
+    }
+
+    size_t i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= count; i += 8) {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m256 distance = _mm256_set1_ps(planes[p].d);
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].normal.x), _mm256_loadu_ps(inputs[p].x + i)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].normal.y), _mm256_loadu_ps(inputs[p].y + i)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].normal.z), _mm256_loadu_ps(inputs[p].z + i)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        int mask = _mm256_movemask_ps(inside);
+        while (mask) {
+            int bit = std::countr_zero(static_cast<unsigned int>(mask));
+            visibleOut.push_back(static_cast<uint32_t>(i + bit));
+            mask &= mask - 1;
+        }
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m128 distance = _mm_set1_ps(planes[p].d);
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].normal.x), _mm_loadu_ps(inputs[p].x + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].normal.y), _mm_loadu_ps(inputs[p].y + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].normal.z), _mm_loadu_ps(inputs[p].z + i)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+        }
+        int mask = _mm_movemask_ps(inside);
+        while (mask) {
+            int bit = std::countr_zero(static_cast<unsigned int>(mask));
+            visibleOut.push_back(static_cast<uint32_t>(i + bit));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        bool inside = true;
+        for (int p = 0; p < 6; ++p) {
+            const glm::vec3& n = planes[p].normal;
+            float distance = n.x * inputs[p].x[i] + n.y * inputs[p].y[i] + n.z * inputs[p].z[i] + planes[p].d;
+            inside = inside && distance >= 0;
+        }
+        if (inside)
+            visibleOut.push_back(static_cast<uint32_t>(i));
+    }
+}
@@ -0,0 +1,153 @@
+#include "utils/geometry.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // points closer than this are treated as crossing the near plane
+    const float MIN_W = 0.1f;
+
+    glm::vec3 boxCorner(const glm::vec3& min, const glm::vec3& max, int i)
+    {
+        return {i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z};
+    }
+
+    // corners of each side of a box, in boxCorner order, wound around the side
+    const int BOX_SIDES[6][4] = {
+        {0, 2, 6, 4}, // -x
+        {1, 3, 7, 5}, // +x
+        {0, 1, 5, 4}, // -y
+        {2, 3, 7, 6}, // +y
+        {0, 1, 3, 2}, // -z
+        {4, 5, 7, 6}  // +z
+    };
+}
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : m_width(width), m_height(height), m_depth(width * height, 0.0f)
+{
+}
+
+void OcclusionBuffer::clear(const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
+{
+    m_viewProjection = viewProjection;
+    m_cameraPosition = cameraPosition;
+    std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+}
+
+void OcclusionBuffer::addOccluder(const glm::vec3& min, const glm::vec3& max)
+{
+    std::array<ScreenVertex, 8> corners;
+    for (int i = 0; i < 8; ++i)
+    {
+        // clipping is not worth it for occluders, so just skip the ones crossing the near plane
+        if (!project(boxCorner(min, max, i), &corners[i]))
+            return;
+    }
+
+    // only the sides facing the camera can be the closest surface
+    const bool facing[6] = {
+        m_cameraPosition.x < min.x, m_cameraPosition.x > max.x,
+        m_cameraPosition.y < min.y, m_cameraPosition.y > max.y,
+        m_cameraPosition.z < min.z, m_cameraPosition.z > max.z
+    };
+    for (int side = 0; side < 6; ++side)
+    {
+        if (!facing[side])
+            continue;
+        const int* c = BOX_SIDES[side];
+        rasterizeTriangle(corners[c[0]], corners[c[1]], corners[c[2]]);
+        rasterizeTriangle(corners[c[0]], corners[c[2]], corners[c[3]]);
+    }
+}
+
+bool OcclusionBuffer::isVisible(const glm::vec3& min, const glm::vec3& max) const
+{
+    float minX = INFINITY, minY = INFINITY;
+    float maxX = -INFINITY, maxY = -INFINITY;
+    float nearestInvW = 0.0f;
+    for (int i = 0; i < 8; ++i)
+    {
+        ScreenVertex v;
+        if (!project(boxCorner(min, max, i), &v))
+            return true;
+        minX = std::min(minX, v.x);
+        minY = std::min(minY, v.y);
+        maxX = std::max(maxX, v.x);
+        maxY = std::max(maxY, v.y);
+        nearestInvW = std::max(nearestInvW, v.invW);
+    }
+
+    // every pixel the rect touches, not only the ones whose centers it covers
+    int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+    int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+    int x1 = std::min(m_width - 1, static_cast<int>(std::floor(maxX)));
+    int y1 = std::min(m_height - 1, static_cast<int>(std::floor(maxY)));
+    if (x0 > x1 || y0 > y1)
+        return true;
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        // a branch free min over the row so the compiler can vectorize it
+        const float* row = &m_depth[y * m_width];
+        float rowMin = INFINITY;
+        for (int x = x0; x <= x1; ++x)
+            rowMin = std::min(rowMin, row[x]);
+        if (rowMin <= nearestInvW)
+            return true;
+    }
+    return false;
+}
+
+bool OcclusionBuffer::project(const glm::vec3& point, ScreenVertex* out) const
+{
+    glm::vec4 clip = m_viewProjection * glm::vec4(point.x, point.y, point.z, 1.0f);
+    if (clip.w < MIN_W)
+        return false;
+    float invW = 1.0f / clip.w;
+    out->x = (clip.x * invW * 0.5f + 0.5f) * m_width;
+    out->y = (clip.y * invW * 0.5f + 0.5f) * m_height;
+    out->invW = invW;
+    return true;
+}
+
+void OcclusionBuffer::rasterizeTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c)
+{
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (std::abs(area) < 1e-6f)
+        return;
+    // both windings are rasterized, so flip the edge functions to be positive inside
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    float invArea = 1.0f / std::abs(area);
+
+    // pixels whose centers lie in the triangle's bounds
+    int x0 = std::max(0, static_cast<int>(std::ceil(std::min({a.x, b.x, c.x}) - 0.5f)));
+    int y0 = std::max(0, static_cast<int>(std::ceil(std::min({a.y, b.y, c.y}) - 0.5f)));
+    int x1 = std::min(m_width - 1, static_cast<int>(std::floor(std::max({a.x, b.x, c.x}) - 0.5f)));
+    int y1 = std::min(m_height - 1, static_cast<int>(std::floor(std::max({a.y, b.y, c.y}) - 0.5f)));
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    // edge functions are linear, so step them by their x derivative along each row
+    float e0dx = sign * (b.y - c.y), e1dx = sign * (c.y - a.y), e2dx = sign * (a.y - b.y);
+    for (int y = y0; y <= y1; ++y)
+    {
+        float py = y + 0.5f;
+        float px = x0 + 0.5f;
+        float e0 = sign * ((c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x));
+        float e1 = sign * ((a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x));
+        float e2 = sign * ((b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x));
+        float* row = &m_depth[y * m_width];
+        // no early outs or data dependent branches so the compiler can vectorize the row
+        for (int x = x0; x <= x1; ++x)
+        {
+            float i = static_cast<float>(x - x0);
+            float w0 = e0 + e0dx * i;
+            float w1 = e1 + e1dx * i;
+            float w2 = e2 + e2dx * i;
+            bool inside = w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f;
+            float depth = (w0 * a.invW + w1 * b.invW + w2 * c.invW) * invArea;
+            row[x] = inside ? std::max(row[x], depth) : row[x];
+        }
+    }
+}
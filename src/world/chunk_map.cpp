@@ -210,6 +210,16 @@ BlockType ChunkMap::getBlock(const glm::ivec3& pos) const
     return getBlock(pos.x, pos.y, pos.z);
 }
 
+void ChunkMap::BlockCursor::resolve(const glm::ivec3& chunkPos)
+{
+    m_chunk = m_chunkMap->getChunk(chunkPos);
+    m_chunkPos = chunkPos;
+    m_resolved = true;
+    ++m_chunkLookups;
+    bool complete = m_chunk && m_chunk->getGenerationState() == ChunkGenerationState::Complete;
+    m_blocks = complete ? m_chunk->getBlockData().data() : nullptr;
+}
+
 uint16_t ChunkMap::getSunLight(int x, int y, int z) const
 {
     glm::ivec3 pos(x, y, z);
@@ -298,6 +308,14 @@ std::shared_ptr<const Chunk> ChunkMap::getChunk(const glm::ivec3& pos) const
     return getChunk(pos.x, pos.y, pos.z);
 }
 
+std::shared_ptr<Chunk> ChunkMap::getChunkForWrite(const glm::ivec3& pos)
+{
+    auto chunk = getChunkInternal(pos);
+    if (!chunk || chunk->getGenerationState() < ChunkGenerationState::Complete)
+        return nullptr;
+    return checkCopy2Write(chunk);
+}
+
 std::vector<std::shared_ptr<const Chunk>> ChunkMap::getChunksInRadius(const glm::ivec3 &chunkPos, int radius) const
 {
     std::vector<std::shared_ptr<const Chunk>> chunksInRadius;
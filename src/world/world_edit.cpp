@@ -0,0 +1,214 @@
+#include "world/world_edit.h"
+#include <algorithm>
+#include <unordered_set>
+#include "world/chunk_map.h"
+#include "world/chunk_snapshot.h"
+
+void WorldEdit::fillBox(const glm::ivec3& min, const glm::ivec3& max, BlockType type)
+{
+    edit(min, max, [type](const glm::ivec3&, BlockType) { return type; });
+}
+
+void WorldEdit::fillSphere(const glm::vec3& center, float radius, BlockType type)
+{
+    glm::ivec3 min = glm::floor(center - radius);
+    glm::ivec3 max = glm::floor(center + radius);
+    float radius2 = radius * radius;
+    edit(min, max, [&](const glm::ivec3& pos, BlockType current) {
+        glm::vec3 d = glm::vec3(pos) + 0.5f - center;
+        return glm::dot(d, d) <= radius2 ? type : current;
+    });
+}
+
+void WorldEdit::replace(const glm::ivec3& min, const glm::ivec3& max, BlockType from, BlockType to)
+{
+    edit(min, max, [from, to](const glm::ivec3&, BlockType current) {
+        return current == from ? to : current;
+    });
+}
+
+void WorldEdit::paste(const glm::ivec3& origin, const VoxelBuffer& buffer, bool skipAir)
+{
+    if (buffer.size.x <= 0 || buffer.size.y <= 0 || buffer.size.z <= 0)
+        return;
+    edit(origin, origin + buffer.size - 1, [&](const glm::ivec3& pos, BlockType current) {
+        glm::ivec3 p = pos - origin;
+        BlockType type = buffer.get(p.x, p.y, p.z);
+        return skipAir && type == BlockType::Air ? current : type;
+    });
+}
+
+template<typename BlockFunc>
+void WorldEdit::edit(const glm::ivec3& min, const glm::ivec3& max, BlockFunc blockAt)
+{
+    glm::ivec3 minChunk = Chunk::globalToChunkPos(min);
+    glm::ivec3 maxChunk = Chunk::globalToChunkPos(max);
+    for (int cx = minChunk.x; cx <= maxChunk.x; ++cx)
+    {
+        for (int cz = minChunk.z; cz <= maxChunk.z; ++cz)
+        {
+            for (int cy = minChunk.y; cy <= maxChunk.y; ++cy)
+            {
+                glm::ivec3 chunkPos(cx, cy, cz);
+                glm::ivec3 chunkOrigin = chunkPos * Chunk::CHUNK_SIZE;
+                // the part of the box inside this chunk, in local coordinates
+                glm::ivec3 localMin = glm::max(min - chunkOrigin, glm::ivec3(0));
+                glm::ivec3 localMax = glm::min(max - chunkOrigin, glm::ivec3(Chunk::CHUNK_SIZE - 1));
+                ChunkEdit* chunkEdit = getChunkEdit(chunkPos);
+                if (!chunkEdit)
+                    continue;
+
+                Chunk& chunk = *chunkEdit->chunk;
+                const auto& blocks = chunk.getBlockData();
+                for (int x = localMin.x; x <= localMax.x; ++x)
+                {
+                    for (int z = localMin.z; z <= localMax.z; ++z)
+                    {
+                        // y is the innermost index, so each column is a contiguous span of the block array
+                        for (int y = localMin.y; y <= localMax.y; ++y)
+                        {
+                            int index = Chunk::getIndex(x, y, z);
+                            BlockType current = blocks[index];
+                            BlockType type = blockAt(chunkOrigin + glm::ivec3(x, y, z), current);
+                            if (type == current)
+                                continue;
+                            chunk.setBlock(x, y, z, type);
+                            if (!chunkEdit->changed[index])
+                            {
+                                chunkEdit->changed[index] = true;
+                                ++m_changedBlocks;
+                            }
+                            chunkEdit->localMin = glm::min(chunkEdit->localMin, glm::ivec3(x, y, z));
+                            chunkEdit->localMax = glm::max(chunkEdit->localMax, glm::ivec3(x, y, z));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+WorldEdit::ChunkEdit* WorldEdit::getChunkEdit(const glm::ivec3& chunkPos)
+{
+    auto it = m_chunkEdits.find(chunkPos);
+    if (it != m_chunkEdits.end())
+        return &it->second;
+
+    // copied once per batch, so mesh builds holding the old chunk never see a half finished edit
+    auto chunk = m_chunkMap->getChunkForWrite(chunkPos);
+    if (!chunk)
+        return nullptr;
+    ChunkEdit& chunkEdit = m_chunkEdits[chunkPos];
+    chunkEdit.chunk = std::move(chunk);
+    return &chunkEdit;
+}
+
+std::vector<glm::ivec3> WorldEdit::commit()
+{
+    std::vector<glm::ivec3> editedChunks;
+    for (const auto& [chunkPos, chunkEdit] : m_chunkEdits)
+    {
+        if (chunkEdit.changed.any())
+            editedChunks.push_back(chunkPos);
+    }
+    // top down, so sunlight let in by one chunk has reached the chunk below before it is relit
+    std::sort(editedChunks.begin(), editedChunks.end(), [](const glm::ivec3& a, const glm::ivec3& b) {
+        if (a.y != b.y)
+            return a.y > b.y;
+        if (a.x != b.x)
+            return a.x < b.x;
+        return a.z < b.z;
+    });
+
+    std::unordered_set<glm::ivec3, glm_ivec3_hash, glm_ivec3_equal> dirtyChunks;
+    for (const auto& chunkPos : editedChunks)
+    {
+        const ChunkEdit& chunkEdit = m_chunkEdits.at(chunkPos);
+        if (relightChunk(chunkPos, chunkEdit))
+        {
+            // light spreads into every neighbor
+            for (int x = -1; x <= 1; ++x)
+                for (int y = -1; y <= 1; ++y)
+                    for (int z = -1; z <= 1; ++z)
+                        dirtyChunks.insert(chunkPos + glm::ivec3(x, y, z));
+            continue;
+        }
+
+        // without a relight only neighbors next to a changed block mesh it, for faces and AO
+        glm::ivec3 lo(0), hi(0);
+        for (int i = 0; i < 3; ++i)
+        {
+            lo[i] = chunkEdit.localMin[i] == 0 ? -1 : 0;
+            hi[i] = chunkEdit.localMax[i] == Chunk::CHUNK_SIZE - 1 ? 1 : 0;
+        }
+        for (int x = lo.x; x <= hi.x; ++x)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int z = lo.z; z <= hi.z; ++z)
+                    dirtyChunks.insert(chunkPos + glm::ivec3(x, y, z));
+    }
+
+    m_chunkEdits.clear();
+    m_changedBlocks = 0;
+    return std::vector<glm::ivec3>(dirtyChunks.begin(), dirtyChunks.end());
+}
+
+bool WorldEdit::relightChunk(const glm::ivec3& chunkPos, const ChunkEdit& chunkEdit)
+{
+    // read from the map rather than chunkEdit, an earlier relight may have replaced the chunk
+    auto snapshot = ChunkSnapshot::CreateSnapshot(*m_chunkMap, chunkPos, ChunkGenerationState::Blocks);
+    if (!snapshot)
+        return false;
+
+    // the same rules as ChunkMapRenderer::queueBlockUpdate, gathered for every changed block
+    std::vector<LightQueueNode> blockLightsToRemove, blockLightsToAdd, sunLightsToRemove, sunLightsToAdd;
+    glm::ivec3 chunkOrigin = chunkPos * Chunk::CHUNK_SIZE;
+    for (int x = chunkEdit.localMin.x; x <= chunkEdit.localMax.x; ++x)
+    {
+        for (int z = chunkEdit.localMin.z; z <= chunkEdit.localMax.z; ++z)
+        {
+            for (int y = chunkEdit.localMin.y; y <= chunkEdit.localMax.y; ++y)
+            {
+                if (!chunkEdit.changed[Chunk::getIndex(x, y, z)])
+                    continue;
+                glm::ivec3 localPos(x, y, z);
+                glm::ivec3 blockPos = chunkOrigin + localPos;
+                BlockType blockType = snapshot->getBlockFromLocalPos(localPos);
+
+                uint16_t curLight = snapshot->getBlockLightFromLocalPos(localPos);
+                uint16_t newLight = BlockData::getLuminosity(blockType);
+                if (newLight > curLight) {
+                    blockLightsToAdd.push_back({blockPos, newLight});
+                } else if (newLight < curLight) {
+                    blockLightsToRemove.push_back({blockPos, newLight});
+                } else if (blockType == BlockType::Air) {
+                    uint16_t nearbyLight = snapshot->getNearbyBlockLight(localPos);
+                    if (nearbyLight > 1)
+                        blockLightsToAdd.push_back({blockPos, static_cast<uint16_t>(nearbyLight - 1)});
+                }
+
+                if (blockType == BlockType::Air) {
+                    if (snapshot->getSunLightFromLocalPos(localPos + glm::ivec3(0, 1, 0)) == 15) {
+                        sunLightsToAdd.push_back({blockPos, 15});
+                    } else {
+                        uint16_t nearbyLight = snapshot->getNearbySkyLight(localPos);
+                        if (nearbyLight > 1)
+                            sunLightsToAdd.push_back({blockPos, static_cast<uint16_t>(nearbyLight - 1)});
+                    }
+                } else if (BlockData::isOpaqueBlock(blockType)) {
+                    if (snapshot->getNearbySkyLight(localPos) > 1)
+                        sunLightsToRemove.push_back({blockPos, 0});
+                }
+            }
+        }
+    }
+
+    if (!blockLightsToRemove.empty())
+        m_chunkMap->removeLights(chunkPos, blockLightsToRemove, true);
+    if (!blockLightsToAdd.empty())
+        m_chunkMap->addLights(chunkPos, blockLightsToAdd, true);
+    if (!sunLightsToRemove.empty())
+        m_chunkMap->removeLights(chunkPos, sunLightsToRemove, false);
+    if (!sunLightsToAdd.empty())
+        m_chunkMap->addLights(chunkPos, sunLightsToAdd, false);
+    return true;
+}